@@ -381,6 +381,7 @@ void game_callbacks::apply_key_event(int key, int action) noexcept
 		glPolygonMode(GL_FRONT_AND_BACK, invert(game.is_wireframe_view) ? GL_LINE : GL_FILL);
 	}},
 	{ GLFW_KEY_J, press_bit, [&]{ invert(game.display_chunk_borders); }},
+	{ GLFW_KEY_K, press_bit, [&]{ m_app->m_world.set_column_layout(!m_app->m_world.is_column_layout()); }},
 
 	// Function inputs
 	{ GLFW_KEY_F1, press_bit, [&]{ invert(game.show_any_gui); }},
@@ -675,6 +676,22 @@ void game_callbacks::apply_cmd_text()
 	[&]{ world.update_render_distance(int_arg<int32_t>(0, render_limits.min, render_limits.max)); },
 	[&]{ query("render distance", m_app->m_world.get_rnd_dist()); }
 	},
+	{ "unload",
+		"band *dwell",
+		formatter::fmt("Sets how many chunks past the render distance are kept loaded [%d, %d] and "
+		               "how long to stay in a chunk before updating [%.1f, %.1f]",
+		               unload_band_limits.min, unload_band_limits.max, dwell_limits.min, dwell_limits.max),
+	[&]{
+		world.set_unload_band(
+			int_arg<int32_t>(0, unload_band_limits.min, unload_band_limits.max),
+			has_arg(1) ? dbl_arg(1, dwell_limits.min, dwell_limits.max) : world.get_center_dwell_time()
+		);
+	},
+	[&]{
+		query("unload band", world.get_unload_band());
+		if (m_query_chat) add_chat_text(formatter::fmt("Current dwell time is %.2fs", world.get_center_dwell_time()));
+	}
+	},
 	{ "fov",
 		"",
 		formatter::fmt("Sets the camera FOV. [%.1f, %.1f]", fov_limits.min, fov_limits.max),
@@ -3,6 +3,7 @@
 
 #include "Player/Player.hpp"
 #include "World/Sky.hpp"
+#include "World/Horizon.hpp"
 
 class main_game_obj;
 
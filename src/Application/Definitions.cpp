@@ -42,6 +42,31 @@ void thread_ops::split(int thread_count, size_t work_max_index, thread_function_
 	for (int thread_index = 0; thread_index < spawned_threads; ++thread_index) work_threads[thread_index].join();
 	delete[] work_threads; // Clear thread array
 }
+void thread_ops::split_ordered(int thread_count, size_t work_count, ordered_function_t work_func)
+{
+	if (thread_count <= 0) throw std::invalid_argument("");
+	if (work_count == 0) return;
+
+	// Each thread takes the next unclaimed index rather than a fixed range,
+	// so work is done roughly in the order given and finishes evenly
+	std::atomic<size_t> next_index{ 0u };
+	const auto claim_loop = [&](int thread_index) {
+		for (size_t index; (index = next_index++) < work_count;) work_func(thread_index, index);
+	};
+
+	// Calling thread also does work so only create as many extra threads as needed
+	const int extra_threads = static_cast<int>(math::min(static_cast<size_t>(thread_count), work_count)) - 1;
+	std::thread *work_threads = new std::thread[extra_threads];
+	for (int thread_index = 0; thread_index < extra_threads; ++thread_index) {
+		work_threads[thread_index] = std::thread(claim_loop, thread_index + 1);
+	}
+	claim_loop(0);
+
+	// Join all created threads
+	for (int thread_index = 0; thread_index < extra_threads; ++thread_index) work_threads[thread_index].join();
+	delete[] work_threads; // Clear thread array
+}
+
 void thread_ops::wait_avg_frame() noexcept
 {
 	// Sleep for 1 screen frame
@@ -244,6 +269,7 @@ void shaders_obj::init_shader_data()
 	// Setup buffers and shader UBO code for shared program data
 	std::string *ubo_list = new std::string[game.shaders.all_ubos.size()];
 	for (shader_ubo_base *ubo : game.shaders.all_ubos) ubo->init(ubo_list);
+	init_ubo_arena();
 
 	// GLSL code golfing to reduce bytes of string
 	// (but some outside indentation is added to reduce eye strain).
@@ -261,40 +287,43 @@ void shaders_obj::init_shader_data()
 	// TODO: uniform+layout shortcut
 
 	programs.blocks.init("Blocks", ubo_list,
-		430, ubo_matrices | ubo_times | ubo_positions | ubo_sizes, tex_none,
+		430, ubo_matrices | ubo_times | ubo_relative, tex_none,
 		// Outer code
 		"\n#extension GL_ARB_shader_draw_parameters : require\n"
-		"struct od{double x,z;float y;uint f;};"
+		"struct od{int x,y,z;uint f;};" // Full chunk corner relative to the render base chunk, face and level of detail
 		"layout(std430,binding=0)readonly restrict buffer O{od ol[];};"
-		"uniform uint ls;uniform uint s1;uniform uint s2;uniform uint s3;" // Uniforms
-		"layout(location=0)in uint bd;" // X bits for X,Y,Z depending on settings then rest is texture
-		"layout(location=1)in vec4 sXZ;"
-		"layout(location=2)in vec4 sYZ;"
-		"layout(location=3)in vec4 sYW;"
-		"out vec3 z;\2"
+		"uniform uint ls;uniform uint s1;uniform uint s2;uniform uint s3;uniform uint ly;uniform uint s4;" // Uniforms
+		"uniform int cb;uniform int gx;uniform int gz;" // Chunk bits and generation centre
+		"layout(location=0)in uint bd;" // X bits for X,Y,Z depending on settings, subchunk index then rest is texture
+		// Quad corners for each face direction, in triangle strip order (4 for each face index)
+		"const vec3 Q[24]=vec3[24]("
+			"vec3(1,1,1),vec3(1,0,1),vec3(1,1,0),vec3(1,0,0)," // Right
+			"vec3(0,1,0),vec3(0,0,0),vec3(0,1,1),vec3(0,0,1)," // Left
+			"vec3(1,1,0),vec3(0,1,0),vec3(1,1,1),vec3(0,1,1)," // Up
+			"vec3(0,0,0),vec3(1,0,0),vec3(0,0,1),vec3(1,0,1)," // Down
+			"vec3(0,1,1),vec3(0,0,1),vec3(1,1,1),vec3(1,0,1)," // Front
+			"vec3(1,1,0),vec3(1,0,0),vec3(0,1,0),vec3(0,0,0)"  // Back
+		");"
+		"out vec4 z;out vec2 g;\2"
 		// Inner code
 		"const od cd=ol[gl_DrawIDARB];"
-		"dvec3 b_pos=dvec3("
-			"bd&ls,"
-			"(bd>>s1)&ls,"
-			"(bd>>s2)&ls"
-		")+dvec3(cd.x,cd.y,cd.z);"
-		     "if(cd.f==0)b_pos+=sXZ.wyx;"
-		"else if(cd.f==1)b_pos+=sYZ.zyx;"
-		"else if(cd.f==2)b_pos+=sYZ.ywx;"
-		"else if(cd.f==3)b_pos+=sYW.yzx;"
-		"else if(cd.f==4)b_pos+=sYZ.xyw;"
-		           "else b_pos+=sXZ.xyz;"
-		"const vec3 rl=vec3(b_pos-P_player.xyz);"
+		"vec3 b_pos=(vec3(bd&ls,(bd>>s1)&ls,(bd>>s2)&ls)+Q[((cd.f&7u)*4u)+uint(gl_VertexID)])*float(1u<<(cd.f>>3u))" // Scaled by the detail
+			"+vec3(cd.x,cd.y+int(((bd>>s3)&ly)<<s1),cd.z);"
+		"const vec3 rl=b_pos-R_camera.xyz;"
 		"gl_Position=M_origin*vec4(rl,1.0);"
-		"z=vec3("
-			"((sYZ.x+float(bd>>s3)))*S_blocks,"
-			"sYW.y,"
+		"g=(b_pos.xz/float(1<<cb))-vec2(gx,gz);" // Position in chunks from the generation centre
+		"z=vec4("
+			"vec2(float(gl_VertexID>>1),float(gl_VertexID&1))*float(1u<<(cd.f>>3u))," // Texture coordinates from the corner index, repeated for each block
+			"float(bd>>s4)," // Texture ID is the layer of the blocks texture
 			"clamp((T_f_end-length(rl-vec3(0.0,rl.y*0.9,0.0)))*T_f_range,0.0,1.0)"
 		");",
 		430, ubo_colours, tex_blocks,
-		"in vec3 z;out vec4 f;\2"
-		"f=mix(C_main,texture(TX_blocks,z.xy),z.z);"
+		"uniform int rd;" // Render distance
+		"in vec4 z;in vec2 g;out vec4 f;\2"
+		// Chunks from the render distance onwards are dithered out towards their outer edge, showing the distant terrain behind
+		"if(abs(floor(g.x))+abs(floor(g.y))>=float(rd)&&"
+		   "float(rd)+0.5-abs(g.x-0.5)-abs(g.y-0.5)<fract(52.98292*fract(dot(gl_FragCoord.xy,vec2(0.06711056,0.00583715)))))discard;"
+		"f=mix(C_main,texture(TX_blocks,z.xyz),z.w);"
 		"if(f.a==0.0)discard;"
 	);
 	programs.border.init("Border", ubo_list,
@@ -321,8 +350,30 @@ void shaders_obj::init_shader_data()
 		"f=vec4(mix(C_main,vec4(c.xyz,1.0),c.w));"
 		"if(c.w==0.0)discard;"
 	);
+	programs.horizon.init("Horizon", ubo_list,
+		430, ubo_matrices | ubo_times | ubo_relative, tex_none,
+		// Outer code
+		"uniform int tv;uniform int ts;uniform int tb;uniform int sb;uniform float wy;" // Tile sizes and water level
+		"uniform int hw;uniform int hx;uniform int hz;uniform int bx;uniform int bz;" // Grid width, wrapped lowest tile and its position
+		"layout(location=0)in vec2 h;" // Surface height and shade
+		"out vec3 p;out vec3 s;\2"
+		// Inner code
+		"const int v=gl_VertexID%tv,l=gl_VertexID/tv;" // Vertex inside the tile and slot of the tile
+		"const ivec2 t=ivec2(((l/hw)-hx+hw)%hw,((l%hw)-hz+hw)%hw);" // Tile relative to the lowest tile in the grid
+		"p=vec3(float(bx+(t.x*tb)+((v/ts)*sb)),max(h.x,wy),float(bz+(t.y*tb)+((v%ts)*sb)));"
+		"const vec3 rl=p-R_camera.xyz;"
+		"gl_Position=M_origin*vec4(rl,1.0);"
+		"s=vec3(h,clamp((T_f_end-length(rl-vec3(0.0,rl.y*0.9,0.0)))*T_f_range,0.0,1.0));",
+		430, ubo_colours, tex_none,
+		"uniform int cb;uniform int gx;uniform int gz;uniform int rd;uniform float wy;" // Chunk bits, generation centre and render distance
+		"in vec3 p;in vec3 s;out vec4 f;\2"
+		"const ivec2 c=(ivec2(floor(p.xz))>>cb)-ivec2(gx,gz);"
+		"if(abs(c.x)+abs(c.y)<rd)discard;" // Chunks are drawn instead within the render distance, fading into this in the last one
+		"const vec3 b=s.x<=wy?vec3(0.2,0.38,0.78):(s.x<wy+1.5?vec3(0.86,0.8,0.55):vec3(0.36,0.6,0.24))*s.y;" // Water, sand or grass
+		"f=mix(C_main,vec4(b,1.0),s.z);"
+	);
 	programs.inventory.init("Inventory", ubo_list,
-		430, ubo_sizes, tex_none,
+		430, ubo_none, tex_none,
 		// Outer code
 		"uniform const vec4 T[4]={"
 			"vec4(0.5,0.0,0.2,0.0)," // Background
@@ -333,21 +384,21 @@ void shaders_obj::init_shader_data()
 		"layout(location=0)in vec4 a;" // X, Y, W, H
 		"layout(location=1)in uint b;" // Texture + type (bit 0)
 		"layout(location=2)in vec3 B;" // Base quad coords
-		"out vec2 c;out flat int i;\2"
+		"out vec3 c;out flat int i;\2"
 		// Inner code
 		"const uint I=b>>1;"
 		"if((b&1)==1){"
 			"i=1;"
-			"c=vec2((B.x+float(I))*S_blocks,B.z);"
+			"c=vec3(B.x,B.z,float(I));" // Block texture ID as the layer
 		"}else{"
 			"i=0;"
 			"const vec4 t=T[I];"
-			"c=vec2((B.x*t.y)+t.x,(B.y*t.w)+t.z);"
+			"c=vec3((B.x*t.y)+t.x,(B.y*t.w)+t.z,0.0);"
 		"}"
 		"gl_Position=vec4(a.x+(B.x*a.z),a.y+(B.y*a.w),0.0,1.0);",
 		430, ubo_none, tex_blocks | tex_inventory,
-		"out vec4 f;in vec2 c;in flat int i;\2"
-		"f=texture(i==0?TX_inventory:TX_blocks,c);"
+		"out vec4 f;in vec3 c;in flat int i;\2"
+		"f=i==0?texture(TX_inventory,c.xy):texture(TX_blocks,c);"
 	);
 	programs.outline.init("Outline", ubo_list,
 		430, ubo_matrices | ubo_positions, tex_none,
@@ -575,8 +626,7 @@ void shaders_obj::base_prog::create_shader(
 skip_incl_ubos:
 
 	// Add chosen textures
-	const std::string base_sampler = "uniform sampler2D TX_";
-	std::string textures_incl_res;
+	const std::string base_sampler = "TX_";
 
 	constexpr size_t textures_count = sizeof(shader_texture_list) / sizeof(shader_texture_list::texture_obj);
 	const shader_texture_list::texture_obj *const textures_ptr = reinterpret_cast<shader_texture_list::texture_obj*>(&game.shaders.textures);
@@ -587,8 +637,8 @@ skip_incl_ubos:
 		decltype(textures_ptr) curr_tex = textures_ptr + i;
 		if (incl_texs & (1u << (curr_tex->bind_id - first_bind))) {
 			const std::string texture_def = base_sampler + curr_tex->filename;
-			tex_res->emplace_back(texture_res_obj{ static_cast<GLint>(curr_tex->bind_id), texture_def.substr(18) });
-			result += texture_def + ';';
+			tex_res->emplace_back(texture_res_obj{ static_cast<GLint>(curr_tex->bind_id), texture_def });
+			result += (curr_tex->is_array ? "uniform sampler2DArray " : "uniform sampler2D ") + texture_def + ';';
 		}
 	}
 skip_incl_texs:
@@ -666,13 +716,10 @@ shaders_obj::shader_ubo_base::shader_ubo_base(
 
 void shaders_obj::shader_ubo_base::init(std::string *const ubo_list)
 {
-	ubo = ogl::new_buf(GL_UNIFORM_BUFFER);
-
-	// Buffer correct amount of bytes depending on given type enum
+	// Reserve the correct amount of arena bytes depending on given type enum
 	// and the number of commas + 1 in the variables string
 	const int num_bytes = game.shaders.glob_types_data[bytes_type].bytes * (formatter::count_char(starting_vals, ',') + 1);
-	glBufferStorage(GL_UNIFORM_BUFFER, static_cast<GLsizeiptr>(num_bytes), nullptr, GL_DYNAMIC_STORAGE_BIT);
-	glBindBufferBase(GL_UNIFORM_BUFFER, defined_id, ubo); // Bind UBO to a specific... binding.
+	arena_bytes = static_cast<GLsizeiptr>(num_bytes);
 
 	// Used for UBO definition construction
 	const std::string base_type_spaced = game.shaders.glob_types_data[bytes_type].name + ' ';
@@ -706,21 +753,69 @@ void shaders_obj::shader_ubo_base::init(std::string *const ubo_list)
 	starting_vals.shrink_to_fit();
 }
 
-void shaders_obj::shader_ubo_base::update_all() const noexcept
+// Values are copied into the arena along with every other UBO on the next commit
+void shaders_obj::shader_ubo_base::update_all() const noexcept { game.shaders.is_ubo_arena_changed = true; }
+
+// -------------------- shaders_obj (UBO arena) --------------------
+
+void shaders_obj::init_ubo_arena()
 {
-	// Update the entire UBO
-	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-	glBufferSubData(GL_UNIFORM_BUFFER, 0, get_data_size(), get_data_ptr());
+	// Each UBO range needs to start at a multiple of the offset alignment
+	GLint offset_alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offset_alignment);
+	const GLsizeiptr alignment = static_cast<GLsizeiptr>(math::max(offset_alignment, 1));
+
+	ubo_arena_slot_bytes = 0;
+	for (shader_ubo_base *ubo : all_ubos) {
+		ubo->arena_offset = ubo_arena_slot_bytes;
+		ubo_arena_slot_bytes += ((ubo->arena_bytes + alignment - 1) / alignment) * alignment;
+	}
+
+	ubo_arena = ogl::new_buf(GL_UNIFORM_BUFFER);
+	const GLsizeiptr total_bytes = ubo_arena_slot_bytes * ubo_arena_slots;
+	constexpr GLbitfield arena_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glBufferStorage(GL_UNIFORM_BUFFER, total_bytes, nullptr, arena_flags);
+	ubo_arena_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, total_bytes, arena_flags));
+
+	ubo_arena_slot = ubo_arena_slots - 1; // First commit uses the first slot
+	is_ubo_arena_changed = true;
 }
 
-void shaders_obj::shader_ubo_base::update_specific(size_t bytes, size_t offset) const noexcept
+void shaders_obj::commit_ubos() noexcept
 {
-	// Update a given part of the UBO
-	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
-	glBufferSubData(GL_UNIFORM_BUFFER, offset, bytes, get_data_ptr());
+	// The previous slot stays bound if no values have changed since the last commit
+	if (!is_ubo_arena_changed || !ubo_arena_mapped) return;
+	is_ubo_arena_changed = false;
+
+	// Every draw since the last commit read from the current slot
+	GLsync &curr_fence = ubo_arena_fences[ubo_arena_slot];
+	if (curr_fence) glDeleteSync(curr_fence);
+	curr_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// Wait for the GPU to finish with the next slot before writing into it (usually already signaled)
+	ubo_arena_slot = (ubo_arena_slot + 1) % ubo_arena_slots;
+	GLsync &next_fence = ubo_arena_fences[ubo_arena_slot];
+	if (next_fence) {
+		while (glClientWaitSync(next_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000u) == GL_TIMEOUT_EXPIRED);
+		glDeleteSync(next_fence);
+		next_fence = nullptr;
+	}
+
+	// Copy all the UBO values with plain stores and point each binding to its range
+	const GLintptr slot_offset = ubo_arena_slot_bytes * ubo_arena_slot;
+	for (const shader_ubo_base *ubo : all_ubos) {
+		const GLintptr ubo_offset = slot_offset + ubo->arena_offset;
+		::memcpy(ubo_arena_mapped + ubo_offset, ubo->get_data_ptr(), math::min(ubo->get_data_size(), static_cast<size_t>(ubo->arena_bytes)));
+		glBindBufferRange(GL_UNIFORM_BUFFER, static_cast<GLuint>(ubo->defined_id), ubo_arena, ubo_offset, ubo->arena_bytes);
+	}
 }
 
-shaders_obj::shader_ubo_base::~shader_ubo_base() { if (game.libraries_inited) glDeleteBuffers(1, &ubo); }
+shaders_obj::~shaders_obj()
+{
+	if (!game.libraries_inited) return;
+	for (GLsync fence : ubo_arena_fences) if (fence) glDeleteSync(fence);
+	glDeleteBuffers(1, &ubo_arena); // Also unmaps the arena
+}
 
 // -------------------- shaders_obj::texture_obj -------------------- 
 
@@ -730,39 +825,75 @@ void shaders_obj::shader_texture_list::texture_obj::add_ogl_img() noexcept
 	glGenTextures(1, &bind_id); // Create a new texture object
 	
 	// Set the newly created texture as the currently bound one
+	const GLenum target = is_array ? GL_TEXTURE_2D_ARRAY : GL_TEXTURE_2D;
 	glActiveTexture(GL_TEXTURE0 + bind_id - 1); // GL_TEXTURE0, GL_TEXTURE1, ...
-	glBindTexture(GL_TEXTURE_2D, bind_id);
+	glBindTexture(target, bind_id);
 
 	// Determine pixel colour to show depending on texture coordinates - nearest or combined
 	// Optionally determine mipmap level selection method with same options
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmap_param == GL_DONT_CARE ? GL_NEAREST : mipmap_param);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, mipmap_param == GL_DONT_CARE ? GL_NEAREST : mipmap_param);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
 	// Texture coordinate overflow handling
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, wrap_param);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, wrap_param);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, wrap_param);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, wrap_param);
 
 	// Determine 'border' colour with clamp wrap setting
 	if (wrap_param == GL_CLAMP_TO_BORDER) {
 		const float border_cols[4] { 1.0f, 0.0f, 0.0f, 1.0f };
-		glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border_cols);
+		glTexParameterfv(target, GL_TEXTURE_BORDER_COLOR, border_cols);
 	}
 
 	// Save the given texture data into the currently bound texture object
-	glTexImage2D(
-		GL_TEXTURE_2D, 0, ogl_display_fmt,
-		static_cast<GLsizei>(width), static_cast<GLsizei>(height),
-		0, static_cast<GLenum>(ogl_display_fmt),
-		GL_UNSIGNED_BYTE, pixels
-	);
+	if (is_array) {
+		// Each layer is its own image, so sampling (and mipmapping) never bleeds into the neighbouring textures
+		// and a layer can be repeated across a larger surface. Layers are read straight from the side by side images.
+		const GLsizei layer_size = static_cast<GLsizei>(height), layers = static_cast<GLsizei>(width / height);
+		glTexImage3D(
+			GL_TEXTURE_2D_ARRAY, 0, ogl_display_fmt, layer_size, layer_size, layers,
+			0, static_cast<GLenum>(ogl_display_fmt), GL_UNSIGNED_BYTE, nullptr
+		);
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, static_cast<GLint>(width));
+		for (GLsizei layer = 0; layer < layers; ++layer) {
+			glPixelStorei(GL_UNPACK_SKIP_PIXELS, layer * layer_size);
+			glTexSubImage3D(
+				GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layer_size, layer_size, 1,
+				static_cast<GLenum>(ogl_display_fmt), GL_UNSIGNED_BYTE, pixels
+			);
+		}
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	} else {
+		glTexImage2D(
+			GL_TEXTURE_2D, 0, ogl_display_fmt,
+			static_cast<GLsizei>(width), static_cast<GLsizei>(height),
+			0, static_cast<GLenum>(ogl_display_fmt),
+			GL_UNSIGNED_BYTE, pixels
+		);
+	}
 
 	// Create mipmaps (with bias setting for different LODs) for the texture 
 	if (mipmap_param != GL_DONT_CARE) {
-		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_LOD_BIAS, lod_bias);
-		glGenerateMipmap(GL_TEXTURE_2D);
+		glTexParameterf(target, GL_TEXTURE_LOD_BIAS, lod_bias);
+		glGenerateMipmap(target);
 	}
 
-	::free(pixels); // No longer need image data - loaded for use in shaders
+	if (!is_pixels_mapped) ::free(pixels); // No longer need image data - loaded for use in shaders
+	pixels = nullptr;
+}
+
+size_t shaders_obj::shader_texture_list::texture_obj::get_pixels_bytes() const noexcept
+{
+	size_t channels = 1u;
+	switch (stored_col_fmt) {
+		case LodePNGColorType::LCT_RGBA: channels = 4u; break;
+		case LodePNGColorType::LCT_RGB: channels = 3u; break;
+		case LodePNGColorType::LCT_GREY_ALPHA: channels = 2u; break;
+		default: break;
+	}
+	// Rows of images with less than 8 bits per pixel are padded to whole bytes
+	return ((static_cast<size_t>(width) * channels * bit_depth + 7u) / 8u) * height;
 }
 
 shaders_obj::shader_texture_list::texture_obj::~texture_obj() { if (game.libraries_inited) glDeleteTextures(1, &bind_id); }
@@ -804,6 +935,148 @@ void file_sys::create_path(std::string path)
 	if (err) throw file_sys::file_err("Could not create path"); // Throw on error
 }
 
+bool file_sys::get_file_stamp(const std::string &path, int64_t *mtime, int64_t *size) noexcept
+{
+	struct stat info;
+	if (::stat(path.c_str(), &info) != 0) return false;
+	*mtime = info.st_mtime;
+	*size = info.st_size;
+	return true;
+}
+
+bool file_sys::mapped_file_obj::map(const std::string &path) noexcept
+{
+	unmap();
+
+	#if defined(VOXEL_WINDOWS)
+	file_handle = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file_handle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER file_size;
+	if (::GetFileSizeEx(file_handle, &file_size) && file_size.QuadPart > 0) {
+		mapping_handle = ::CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping_handle) {
+			data = static_cast<const uint8_t*>(::MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+			size = static_cast<size_t>(file_size.QuadPart);
+		}
+	}
+	#else
+	const int file_desc = ::open(path.c_str(), O_RDONLY);
+	if (file_desc < 0) return false;
+
+	struct stat info;
+	if (::fstat(file_desc, &info) == 0 && info.st_size > 0) {
+		void *const mapped = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file_desc, 0);
+		if (mapped != MAP_FAILED) {
+			data = static_cast<const uint8_t*>(mapped);
+			size = static_cast<size_t>(info.st_size);
+		}
+	}
+	::close(file_desc); // Mapping stays valid after the file is closed
+	#endif
+
+	if (data) return true;
+	unmap();
+	return false;
+}
+
+void file_sys::mapped_file_obj::unmap() noexcept
+{
+	#if defined(VOXEL_WINDOWS)
+	if (data) ::UnmapViewOfFile(data);
+	if (mapping_handle) ::CloseHandle(mapping_handle);
+	if (file_handle != INVALID_HANDLE_VALUE) ::CloseHandle(file_handle);
+	mapping_handle = nullptr;
+	file_handle = INVALID_HANDLE_VALUE;
+	#else
+	if (data) ::munmap(const_cast<uint8_t*>(data), size);
+	#endif
+	data = nullptr;
+	size = 0u;
+}
+
+bool file_sys::texture_cache_obj::open(const std::string &path, size_t textures_count) noexcept
+{
+	if (!file.map(path)) return false;
+
+	// Check the header matches this version and the entries fit in the file
+	const header_obj *const header = reinterpret_cast<const header_obj*>(file.data);
+	if (file.size < sizeof(header_obj) + sizeof(entry_obj) * textures_count ||
+		::memcmp(header->magic, "VXTC", sizeof(header->magic)) != 0 ||
+		header->version != cache_version || header->count != textures_count
+	) {
+		close();
+		return false;
+	}
+
+	entries = reinterpret_cast<const entry_obj*>(file.data + sizeof(header_obj));
+	return true;
+}
+
+bool file_sys::texture_cache_obj::load(shaders_obj::shader_texture_list::texture_obj *texture, size_t index) const noexcept
+{
+	if (!entries) return false;
+	const entry_obj &entry = entries[index];
+
+	// Entry has to be for the same unchanged image, stored in the same format
+	if (::strncmp(entry.name, texture->filename.c_str(), sizeof(entry.name)) != 0 ||
+		entry.source_mtime != texture->source_mtime || entry.source_size != texture->source_size ||
+		entry.col_fmt != static_cast<uint32_t>(texture->stored_col_fmt) || entry.bit_depth != texture->bit_depth ||
+		entry.offset > file.size || entry.bytes > file.size - entry.offset
+	) return false;
+
+	texture->width = entry.width;
+	texture->height = entry.height;
+	if (texture->get_pixels_bytes() != entry.bytes) return false;
+
+	texture->pixels = const_cast<unsigned char*>(file.data + entry.offset);
+	texture->is_pixels_mapped = true;
+	return true;
+}
+
+bool file_sys::texture_cache_obj::write(
+	const std::string &path,
+	const shaders_obj::shader_texture_list::texture_obj *textures,
+	size_t count
+) noexcept {
+	std::ofstream file_stream(path, std::ios::binary | std::ios::trunc);
+	if (!file_stream.good()) return false;
+
+	const header_obj header = { { 'V', 'X', 'T', 'C' }, cache_version, static_cast<uint32_t>(count), 0u };
+	file_stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// Pixels of each texture are placed after all the entries, aligned for uploading
+	std::vector<entry_obj> cache_entries(count);
+	uint64_t offset = sizeof(header_obj) + sizeof(entry_obj) * count;
+	for (size_t i = 0; i < count; ++i) {
+		const shaders_obj::shader_texture_list::texture_obj &texture = textures[i];
+		entry_obj &entry = cache_entries[i];
+		::memset(&entry, 0, sizeof(entry));
+		::strncpy(entry.name, texture.filename.c_str(), sizeof(entry.name) - 1u);
+
+		entry.source_mtime = texture.source_mtime;
+		entry.source_size = texture.source_size;
+		entry.width = texture.width;
+		entry.height = texture.height;
+		entry.col_fmt = static_cast<uint32_t>(texture.stored_col_fmt);
+		entry.bit_depth = texture.bit_depth;
+		entry.offset = (offset + data_alignment - 1u) & ~(data_alignment - 1u);
+		entry.bytes = texture.get_pixels_bytes();
+		offset = entry.offset + entry.bytes;
+	}
+	file_stream.write(reinterpret_cast<const char*>(cache_entries.data()), static_cast<std::streamsize>(sizeof(entry_obj) * count));
+
+	for (size_t i = 0; i < count; ++i) {
+		const entry_obj &entry = cache_entries[i];
+		const char padding[data_alignment] = {};
+		const std::streamoff padding_bytes = static_cast<std::streamoff>(entry.offset) - file_stream.tellp();
+		file_stream.write(padding, padding_bytes);
+		file_stream.write(reinterpret_cast<const char*>(textures[i].pixels), static_cast<std::streamsize>(entry.bytes));
+	}
+
+	return file_stream.good();
+}
+
 void file_sys::read(const std::string &filename, std::string &contents, bool message)
 {
 	// Setup file stream (moves to eof with ate bit)
@@ -47,6 +47,7 @@ extern "C" {
 
 // C++ libraries
 #include <mutex>
+#include <atomic>
 #include <thread>
 #include <condition_variable>
 
@@ -58,6 +59,7 @@ extern "C" {
 #include <algorithm>
 #include <functional>
 #include <unordered_map>
+#include <map>
 
 // Local vector header
 #include "World/Generation/Vector.hpp"
@@ -92,6 +94,8 @@ extern "C" {
 #if defined(__unix__) || defined(unix) || defined(__unix) || defined(VOXEL_APPLE)
 #define VOXEL_UNIX
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #endif
 #if defined(sun) || defined(__sun)
 #  if defined(__SVR4) || defined(__svr4__)
@@ -165,7 +169,9 @@ namespace ogl
 // Thread-related functions
 namespace thread_ops {
 	typedef std::function<void(int, size_t, size_t)> thread_function_t;
+	typedef std::function<void(int, size_t)> ordered_function_t;
 	void split(int thread_count, size_t work_array_size, thread_function_t individual_work_func);
+	void split_ordered(int thread_count, size_t work_count, ordered_function_t individual_work_func);
 	void wait_avg_frame() noexcept;
 }
 
@@ -256,29 +262,33 @@ public:
 	struct texture_obj {
 		texture_obj(
 			std::string file_name, LodePNGColorType stored_col_type, unsigned stored_bit_depth,
-			GLint displayed_col_type, GLint wrap_parameter, GLint mipmap_parameter, float mip_lod_bias
+			GLint displayed_col_type, GLint wrap_parameter, GLint mipmap_parameter, float mip_lod_bias, bool is_layered
 		) noexcept :
 			filename(file_name), stored_col_fmt(stored_col_type), bit_depth(stored_bit_depth),
 			ogl_display_fmt(displayed_col_type), wrap_param(wrap_parameter), mipmap_param(mipmap_parameter),
-			lod_bias(mip_lod_bias)
+			lod_bias(mip_lod_bias), is_array(is_layered)
 		{};
 
 		void add_ogl_img() noexcept;
+		size_t get_pixels_bytes() const noexcept;
 
 		const std::string filename;
 		GLuint bind_id = 0;
 		unsigned char *pixels = nullptr;
+		bool is_pixels_mapped = false; // Pixels point into the mapped texture cache rather than a decoded copy
+		int64_t source_mtime = 0, source_size = 0; // Stamp of the image file, used to check cached pixels
 		const LodePNGColorType stored_col_fmt;
 		unsigned width, height, bit_depth;
 		const GLint ogl_display_fmt;
 		const GLint wrap_param;
 		const GLint mipmap_param;
 		const float lod_bias;
+		const bool is_array; // Square images placed side by side in the file are loaded as layers of an array texture
 
 		~texture_obj();
-	} blocks    = { "blocks",    LodePNGColorType::LCT_RGBA, 8u, GL_RGBA, GL_REPEAT, GL_DONT_CARE, 1.0f }, // Blocks atlas texture
-	  inventory = { "inventory", LodePNGColorType::LCT_RGBA, 8u, GL_RGBA, GL_REPEAT, GL_DONT_CARE, 1.0f }, // Inventory elements texture
-	  text      = { "text",      LodePNGColorType::LCT_RGBA, 8u, GL_RGBA, GL_REPEAT, GL_DONT_CARE, 1.0f }; // ASCII text list texture
+	} blocks    = { "blocks",    LodePNGColorType::LCT_RGBA, 8u, GL_RGBA, GL_REPEAT, GL_NEAREST_MIPMAP_LINEAR, 0.0f, true  }, // Block textures, one layer for each texture ID
+	  inventory = { "inventory", LodePNGColorType::LCT_RGBA, 8u, GL_RGBA, GL_REPEAT, GL_DONT_CARE,             1.0f, false }, // Inventory elements texture
+	  text      = { "text",      LodePNGColorType::LCT_RGBA, 8u, GL_RGBA, GL_REPEAT, GL_DONT_CARE,             1.0f, false }; // ASCII text list texture
 	// TODO: text 1bpp, inv 8bpp
 	} textures;
 	enum tex_incl_en : int { tex_none = 0, tex_blocks = 1, tex_inventory = 2, tex_text = 4 };
@@ -293,16 +303,29 @@ public:
 		char start_char;
 		int bytes_type;
 		std::string starting_vals;
-		GLuint ubo = 0;
+		GLintptr arena_offset = 0; // Offset of this UBO inside each arena slot
+		GLsizeiptr arena_bytes = 0;
 		int defined_id = 0;
 
 		virtual const void *get_data_ptr() const noexcept { return nullptr; }
 		virtual size_t get_data_size() const noexcept { return 0; }
 		void update_all() const noexcept;
-		void update_specific(size_t bytes, size_t offset) const noexcept;
-		~shader_ubo_base();
 	};
 
+	// All UBOs are sub-allocated from one persistently mapped buffer split into a slot per frame in flight.
+	// Updates only mark the arena as changed - the values of every UBO are then copied into the next free
+	// slot at once and each binding is pointed to its range in that slot with glBindBufferRange.
+	static constexpr int ubo_arena_slots = 3;
+	GLuint ubo_arena = 0;
+	uint8_t *ubo_arena_mapped = nullptr;
+	GLsizeiptr ubo_arena_slot_bytes = 0;
+	GLsync ubo_arena_fences[ubo_arena_slots]{};
+	int ubo_arena_slot = 0;
+	bool is_ubo_arena_changed = false;
+
+	void init_ubo_arena();
+	void commit_ubos() noexcept;
+
 	// This allows parity between shader and CPU code variable names whilst using struct
 	// members instead of relying on remembering the order of variable declarations.
 	// It also means the string and member version of a value are defined together so they
@@ -329,7 +352,8 @@ public:
 	UBO_DEF(times, 'T', float, cycle,f_end,f_range,stars,global,clouds);
 	UBO_DEF(colours, 'C', vec4, main,evening,light); 
 	UBO_DEF(positions, 'P', dvec4, raycast,player,chunk,offset);
-	UBO_DEF(sizes, 'S', float, blocks,inventory,stars);
+	UBO_DEF(sizes, 'S', float, inventory,stars);
+	UBO_DEF(relative, 'R', vec4, camera);
 	#undef UBO_DEF
 
 	struct base_prog {
@@ -378,10 +402,11 @@ public:
 		GLuint compute = 0;
 	};
 
-	struct shader_progs_list { shader_prog blocks, clouds, inventory, outline, sky, stars, text, planets, border; } programs;
+	struct shader_progs_list { shader_prog blocks, clouds, horizon, inventory, outline, sky, stars, text, planets, border; } programs;
 	struct compute_progs_list { compute_prog faces, stars; } computes;
 
 	void init_shader_data();
+	~shaders_obj();
 };
 
 // File system functions
@@ -397,6 +422,44 @@ namespace file_sys
 
 	void delete_path(std::string path);
 	void create_path(std::string path);
+	bool get_file_stamp(const std::string &path, int64_t *mtime, int64_t *size) noexcept;
+
+	// Read-only view of an entire file mapped into memory
+	struct mapped_file_obj {
+		bool map(const std::string &path) noexcept;
+		void unmap() noexcept;
+
+		const uint8_t *data = nullptr;
+		size_t size = 0u;
+	#if defined(VOXEL_WINDOWS)
+		HANDLE file_handle = INVALID_HANDLE_VALUE, mapping_handle = nullptr;
+	#endif
+
+		~mapped_file_obj() { unmap(); }
+	};
+
+	// Decoded pixels of every texture, kept in a file next to the Resources folder. The file is mapped on
+	// startup and pixels of images that are unchanged (same modification time and size) are used in place
+	// of decoding them again. Entries are in the same order as the textures in shader_texture_list.
+	struct texture_cache_obj {
+		bool open(const std::string &path, size_t textures_count) noexcept;
+		bool load(shaders_obj::shader_texture_list::texture_obj *texture, size_t index) const noexcept;
+		void close() noexcept { file.unmap(); entries = nullptr; }
+		static bool write(const std::string &path, const shaders_obj::shader_texture_list::texture_obj *textures, size_t count) noexcept;
+
+		struct header_obj { char magic[4]; uint32_t version, count, reserved; };
+		struct entry_obj { 
+			char name[32];
+			int64_t source_mtime, source_size;
+			uint32_t width, height, col_fmt, bit_depth;
+			uint64_t offset, bytes;
+		};
+		static constexpr uint32_t cache_version = 1u;
+		static constexpr uint64_t data_alignment = 16u;
+
+		mapped_file_obj file;
+		const entry_obj *entries = nullptr;
+	};
 
 	struct file_err : public std::exception { 
 		const char *err_message;
@@ -413,7 +476,7 @@ struct voxel_global
 {
 	void init() noexcept;
 
-	GLFWwindow *window_ptr;
+	GLFWwindow *window_ptr, *upload_window_ptr = nullptr; // Hidden window for the context of the mesh upload thread
 	uint32_t *faces_lk_ptr;
 	struct global_cleaner { ~global_cleaner(); } cleaner;
 	shaders_obj shaders;
@@ -2,7 +2,8 @@
 
 main_game_obj::main_game_obj() noexcept :
 	events_handler(this),
-	m_world(&m_player_inst.player)
+	m_world(&m_player_inst.player),
+	m_horizon(&m_world.world_noise_objs)
 {
 	m_player_inst.world = &m_world;
 
@@ -104,31 +105,51 @@ void main_game_obj::init_game(int argc, const char *const *const argv)
 		shaders_obj::shader_texture_list::texture_obj*
 	>(&game.shaders.textures);
 
-	// Decode all textures with specified formats into a pixel array
+	// Map the cache of previously decoded textures, which is skipped if it is missing or outdated
+	const std::string cache_path = game.current_exec_dir + "/TextureCache.bin", new_cache_path = cache_path + ".tmp";
+	file_sys::texture_cache_obj texture_cache;
+	texture_cache.open(cache_path, images_load_count);
+	std::atomic<bool> is_cache_outdated{ false };
+
+	// Decode all textures with specified formats into a pixel array, unless they are unchanged in the cache
 	thread_ops::split(math::min(game.available_threads, static_cast<int>(images_load_count)), images_load_count,
 	[&](int, size_t index, size_t end) {
 		for (; index < end; ++index) {
 			shaders_obj::shader_texture_list::texture_obj *const tex_data = textures_ptr + index;
 			// Load in found image and get information data
 			const std::string full_path = game.resources_dir + tex_data->filename + ".png";
+			file_sys::get_file_stamp(full_path, &tex_data->source_mtime, &tex_data->source_size);
+			if (texture_cache.load(tex_data, index)) continue;
+
 			if (lodepng_decode_file(
 				&tex_data->pixels, &tex_data->width, &tex_data->height,
 				full_path.c_str(),
 				tex_data->stored_col_fmt,
 				tex_data->bit_depth
 			)) throw file_sys::file_err(formatter::fmt("Could not find texture %s", full_path.c_str()).c_str());
+			is_cache_outdated = true;
 		}
 	});
 
+	// Write a new cache if any image was decoded - it replaces the mapped one after the textures are created
+	const bool is_cache_written = is_cache_outdated && file_sys::texture_cache_obj::write(new_cache_path, textures_ptr, images_load_count);
+	if (is_cache_outdated && !is_cache_written) formatter::warn("Could not write texture cache", formatter::WARN_FILE);
+
 	// Create an OpenGL image texture object using pixel data and image information
 	for (size_t i = 0; i < images_load_count; ++i) textures_ptr[i].add_ogl_img();
+	texture_cache.close();
+
+	if (is_cache_written) {
+		std::remove(cache_path.c_str());
+		if (std::rename(new_cache_path.c_str(), cache_path.c_str()) != 0) formatter::warn("Could not replace texture cache", formatter::WARN_FILE);
+	}
 
 	game.shaders.init_shader_data(); // Init all shaders, UBOs and other related values
 
-	game.shaders.sizes.vals.blocks = 16.0f / static_cast<float>(game.shaders.textures.blocks.width);
 	game.shaders.sizes.vals.inventory = 1.0f / static_cast<float>(game.shaders.textures.text.width);
 	game.shaders.sizes.vals.stars = 1.0f / static_cast<float>(skybox_elems_obj::stars_count);
 	game.shaders.sizes.update_all();
+	game.shaders.commit_ubos(); // Some values are needed before the first frame
 
 	// Setup blocks shader uniform values
 	const shaders_obj::shader_prog *const blocks_shader = &game.shaders.programs.blocks;
@@ -136,6 +157,9 @@ void main_game_obj::init_game(int argc, const char *const *const argv)
 	blocks_shader->set_uint("s1", static_cast<GLuint>(chunk_vals::size_bits));
 	blocks_shader->set_uint("s2", static_cast<GLuint>(chunk_vals::size_bits * 2));
 	blocks_shader->set_uint("s3", static_cast<GLuint>(chunk_vals::size_bits * 3));
+	blocks_shader->set_uint("ly", static_cast<GLuint>(chunk_vals::y_full_bits));
+	blocks_shader->set_uint("s4", static_cast<GLuint>(chunk_vals::texture_shift));
+	blocks_shader->set_int("cb", chunk_vals::size_bits);
 
 	chunk_vals::fill_lookup(); // Init lookup data
 	game.global_time = glfwGetTime(); // Used for timing this init function and constructor
@@ -180,13 +204,17 @@ void main_game_obj::main_world_loop()
 		m_player_inst.check_movement_input(); // Check for per-frame inputs
 		m_player_inst.apply_velocity(); // Apply smoothed movement using velocity and run other position-related functions
 		if (m_player_inst.player.moved) player_moved_update(); // Update matrices and frustum on position change
+		else m_world.update_pending_sort(); // Use the results of a full sort started on an earlier frame
 		m_world.generation_loop(true); // Possibly update chunks if results from threads are available
+		m_horizon.update_horizon(&m_world.get_gen_center(), m_world.get_rnd_dist()); // Request and upload distant terrain tiles
 
 		update_frame_vals(); // Update shader UBO values (day/night cycle, sky colours)
+		game.shaders.commit_ubos(); // Write all changed UBO values into the arena at once
 
 		// Game rendering
 		m_player_inst.draw_selected_outline();
 		m_world.draw_entire_world();
+		m_horizon.draw_horizon(m_player_inst.player.frustum, m_world.get_render_base());
 		m_skybox.draw_skybox_elements();
 		m_world.draw_enabled_borders();
 
@@ -253,14 +281,18 @@ void main_game_obj::upd_dynamic_text(int *fps_counters) noexcept
 	if (do_text_y_update) m_world_info_txt.set_position_y_relativeto(&m_game_info_txt);
 
 	static const std::string world_info_txt =
-	"Chunks: %s (Rendered: %s)\n"
+	"Chunks: %s (Rendered: %s, Occluded: %s)\n"
 	"Triangles: %s (Rendered: %s)\n"
-	"Rnd.Dist: %d Generating: %d Ind.Calls: %d\n"
+	"Rnd.Dist: %d Generating: %d Overdraw: %.2f\n"
+	"Ind.Calls: %d of %s slots (%s layout)\n"
 	"Time: %.1f (Cycle: %.1f, Day " PRIiMAX ")";
 	m_world_info_txt.set_text(formatter::fmt(world_info_txt, 
 		formatter::group_num(m_world.rendered_map.size() * chunk_vals::y_count).c_str(), formatter::group_num(m_world.rendered_chunks_count).c_str(),
+		formatter::group_num(m_world.occluded_chunks_count).c_str(),
 		formatter::group_num(m_world.existing_quads_count * 2).c_str(), formatter::group_num(m_world.rendered_squares_count * 2).c_str(),
-		m_world.get_rnd_dist(), game.do_generate_signal, m_world.get_ind_calls(),
+		m_world.get_rnd_dist(), game.do_generate_signal, m_world.overdraw_ratio,
+		m_world.get_ind_calls(), formatter::group_num(m_world.get_command_slots_count()).c_str(),
+		m_world.is_column_layout() ? "Column" : "Subchunk",
 		game.global_time, game.cycle_day_seconds, game.world_day_counter
 	)); // Update second text info box
 
@@ -328,8 +360,9 @@ void main_game_obj::player_moved_update() noexcept
 		static_cast<float>(m_player_inst.player.frustum.near_plane),
 		static_cast<float>(m_player_inst.player.frustum.far_plane)
 	) * m_player_inst.get_zero_matrix();
-	game.shaders.matrices.update_specific(sizeof(matrixf4x4), sizeof(matrixf4x4)); // Update UBO matrix value
+	game.shaders.matrices.update_all(); // Update UBO matrix value
 
+	m_world.update_render_base(); // Keep chunk offsets given to the shader close to the camera
 	m_world.sort_world_render(); // Sort the world buffers to determine what needs to be rendered
 	m_player_inst.player.moved = false; // Use to check for next matrix and world buffer update
 }
@@ -348,6 +381,10 @@ void main_game_obj::update_frame_vals() noexcept
 	shaders.positions.vals.raycast = vector3d(player.selected_block_pos) - player.position;
 	shaders.positions.update_all();
 
+	// Camera position relative to the base chunk of the world chunk offsets
+	shaders.relative.vals.camera = player.position - vector3d(m_world.get_render_base() * chunk_vals::size);
+	shaders.relative.update_all();
+
 	// Triangle wave from 0 to 1, reaching 1 at halfway through an in-game day and returning back to 0:
 	// 2 * abs( (x / t) - floor( (x / t) + 0.5 ) ) where x is the current time and t is the time for one full day
 	const double time_div_day_secs = game.cycle_day_seconds / m_skybox.day_seconds;
@@ -368,8 +405,8 @@ void main_game_obj::update_frame_vals() noexcept
 	shaders.times.vals.stars = (rel_day_time - star_display_threshold) * (1.0f / (1.0f - star_display_threshold));
 	shaders.times.vals.global = static_cast<float>(manage_game_time(false));
 	shaders.times.vals.clouds = 1.1f - rel_day_time;
-	// Fog variables
-	const float render_dist = static_cast<float>(m_world.get_rnd_dist());
+	// Fog variables - the fog is past the distant terrain rather than the rendered chunks
+	const float render_dist = static_cast<float>(math::max(m_world.get_rnd_dist(), m_horizon.get_horizon_dist()));
 	shaders.times.vals.f_end =
 		((math::max(render_dist, 1.0f) * chunk_vals::half) + (chunk_vals::half)) + 
 		(rel_day_time * -chunk_vals::half) + // Variance over time - fog is heaviest during midnight
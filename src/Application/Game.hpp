@@ -27,6 +27,7 @@ private:
 	player_inst m_player_inst;
 	world_obj m_world;
 	skybox_elems_obj m_skybox;
+	horizon_obj m_horizon;
 
 	text_renderer_obj::text_obj
 	   m_static_info_txt{},
@@ -29,6 +29,11 @@ static void init_libs()
 	game.window_ptr = glfwCreateWindow(game.window_width, game.window_height, game.def_title.c_str(), nullptr, nullptr);
 	if (!game.window_ptr) formatter::init_abort(VOXEL_ERR_WINDOW_INIT);
 
+	// Hidden window with a context sharing objects with the game window, used by the mesh upload thread
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	game.upload_window_ptr = glfwCreateWindow(1, 1, "", nullptr, game.window_ptr);
+	if (!game.upload_window_ptr) formatter::warn("Failed to create upload context - meshes are uploaded on the main thread");
+
 	glfwMakeContextCurrent(game.window_ptr); // Set GLFW functions to operate on the newly created window
 	
 	// Initialize OGL function loader (glad)
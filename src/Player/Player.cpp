@@ -601,7 +601,7 @@ void player_inst::update_plr_offset() noexcept
 	const world_pos initial = player.offset; // Get initial offset for comparison
 	player.offset = chunk_vals::world_to_offset(&player.position); // Calculate new player offset
 	if (!game.do_generate_signal || (initial.x == player.offset.x && initial.z == player.offset.z)) return;
-	world->signal_generation_thread(); // Update chunks (generation, deletion, etc) if offset changed
+	world->player_offset_changed(); // Update chunks (generation, deletion, etc) if offset changed
 }
 
 void player_inst::upd_cam_vectors() noexcept
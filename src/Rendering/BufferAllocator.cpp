@@ -0,0 +1,61 @@
+#include "BufferAllocator.hpp"
+
+void buffer_allocator_obj::reset(uint32_t capacity) noexcept
+{
+	// Entire buffer is one free range
+	m_free_ranges.clear();
+	if (capacity) m_free_ranges.emplace(0u, capacity);
+	m_capacity = capacity;
+	m_used = 0u;
+}
+
+void buffer_allocator_obj::grow(uint32_t new_capacity) noexcept
+{
+	if (new_capacity <= m_capacity) return;
+
+	// Add the new space at the end, joining it with the last free range if it reaches the previous end
+	range_obj new_range = { m_capacity, new_capacity - m_capacity };
+	m_capacity = new_capacity;
+	m_used += new_range.size; // Counted as used until it is released below
+	release(&new_range);
+}
+
+bool buffer_allocator_obj::allocate(uint32_t size, range_obj *result) noexcept
+{
+	// Use the first free range that is large enough
+	for (auto it = m_free_ranges.begin(); it != m_free_ranges.end(); ++it) {
+		if (it->second < size) continue;
+		*result = { it->first, size };
+
+		// Keep any leftover space as a smaller free range
+		const range_obj leftover = { it->first + size, it->second - size };
+		m_free_ranges.erase(it);
+		if (leftover.size) m_free_ranges.emplace(leftover.start, leftover.size);
+
+		m_used += size;
+		return true;
+	}
+
+	return false; // No range is large enough, buffer needs to grow
+}
+
+void buffer_allocator_obj::release(range_obj *range) noexcept
+{
+	if (!range->size) return;
+	m_used -= range->size;
+	uint32_t start = range->start, size = range->size;
+
+	// Join with the free range directly after this one
+	const auto next = m_free_ranges.find(start + size);
+	if (next != m_free_ranges.end()) {
+		size += next->second;
+		m_free_ranges.erase(next);
+	}
+
+	*range = {};
+
+	// Join with the free range directly before this one
+	auto prev = m_free_ranges.lower_bound(start);
+	if (prev != m_free_ranges.begin() && (--prev, prev->first + prev->second == start)) prev->second += size;
+	else m_free_ranges.emplace(start, size);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#ifndef SOURCE_RENDERING_BUFFER_ALLOCATOR_VXL_HDR
+#define SOURCE_RENDERING_BUFFER_ALLOCATOR_VXL_HDR
+
+#include "Application/Definitions.hpp"
+
+// Keeps track of which ranges of a buffer are in use so that data can be placed into (and removed from)
+// a single large buffer without moving the rest of its contents. Sizes are in elements rather than bytes,
+// the buffer itself is created and resized by the owner of the allocator.
+class buffer_allocator_obj
+{
+public:
+	struct range_obj { uint32_t start, size; };
+
+	void reset(uint32_t capacity) noexcept;
+	void grow(uint32_t new_capacity) noexcept;
+
+	bool allocate(uint32_t size, range_obj *result) noexcept;
+	void release(range_obj *range) noexcept;
+
+	uint32_t get_capacity() const noexcept { return m_capacity; }
+	uint32_t get_used() const noexcept { return m_used; }
+private:
+	std::map<uint32_t, uint32_t> m_free_ranges; // Start and size of each unused range, ordered by start
+	uint32_t m_capacity = 0u, m_used = 0u;
+};
+
+#endif // SOURCE_RENDERING_BUFFER_ALLOCATOR_VXL_HDR
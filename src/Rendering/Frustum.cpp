@@ -1,7 +1,7 @@
 #include "Frustum.hpp"
 
 // Frustum culling - use to only render chunks that are within the player's view
-// For now, only a sphere bounding box is used to simplify calculations done to determine visible chunks
+// Chunks are tested as axis-aligned boxes, using the corner furthest along each plane normal
 // Original source can be found in https://learnopengl.com/Guest-Articles/2021/Scene/Frustum-Culling
 
 camera_frustum::frust_plane::frust_plane(const vector3d &distance_vec, const vector3d &norm) noexcept
@@ -13,6 +13,9 @@ void camera_frustum::update_frustum_vals(
 	const vector3d &cam_right,
 	double fov_y
 ) noexcept {
+	origin = position; front = cam_front; up = cam_up; right = cam_right;
+	fov = fov_y; aspect = game.window_wh_aspect;
+
 	// Calculate frustum values
 	const double half_v_side = far_plane * ::tan(fov_y * 0.5);
 	const double half_h_side = half_v_side * static_cast<double>(game.window_wh_aspect);
@@ -26,23 +29,94 @@ void camera_frustum::update_frustum_vals(
 	bottom_pl = { position, (front_end + cam_up * half_v_side).c_cross(cam_right) };
 
 	near_pl = { position + cam_front * near_plane, cam_front };
+
+	const frust_plane *const planes[5] = { &top_pl, &near_pl, &left_pl, &right_pl, &bottom_pl };
+	for (int i = 0; i < 5; ++i) {
+		const frust_plane *const plane = planes[i];
+		rel_planes[i] = {
+			static_cast<float>(plane->normal.x), static_cast<float>(plane->normal.y), static_cast<float>(plane->normal.z),
+			static_cast<float>(plane->distance - plane->normal.dot(position))
+		};
+	}
 }
 
 bool camera_frustum::is_chunk_visible(const vector3d &corner) const noexcept
 {
-	// Radius of a sphere that would encapsulate an entire chunk - calculated
-	// by half the distance from two opposing corners of a cube (side length = chunk size)
-	// (Using simple radius check for frustum culling to save on performance)
-	constexpr float size_dbl = static_cast<double>(chunk_vals::size);
-	constexpr float chunk_spherical_radius = math::cxpythagoras(math::cxpythagoras(size_dbl, size_dbl), size_dbl) * 0.5f;
-
-	// Get the center of the chunk from given corner
-	constexpr vector3d center_offset = vector3d(0.5 * chunk_vals::size);
-	const vector3d center = corner + center_offset;
-	
-	return top_pl   .neg_dist_to_plane(center) <= chunk_spherical_radius &&
-	       near_pl  .neg_dist_to_plane(center) <= chunk_spherical_radius &&
-	       left_pl  .neg_dist_to_plane(center) <= chunk_spherical_radius &&
-	       right_pl .neg_dist_to_plane(center) <= chunk_spherical_radius &&
-	       bottom_pl.neg_dist_to_plane(center) <= chunk_spherical_radius;
+	// Visible unless the box corner furthest along a plane normal is still outside of that plane
+	constexpr double size_dbl = static_cast<double>(chunk_vals::size);
+	const frust_plane *const planes[5] = { &top_pl, &near_pl, &left_pl, &right_pl, &bottom_pl };
+	for (const frust_plane *const plane : planes) {
+		const vector3d furthest = {
+			corner.x + (plane->normal.x > 0.0 ? size_dbl : 0.0),
+			corner.y + (plane->normal.y > 0.0 ? size_dbl : 0.0),
+			corner.z + (plane->normal.z > 0.0 ? size_dbl : 0.0)
+		};
+		if (plane->neg_dist_to_plane(furthest) > 0.0f) return false;
+	}
+	return true;
+}
+
+void camera_frustum::test_box_batch(
+	const box_batch_obj &boxes,
+	int count,
+	bool test_inside,
+	box_result_en *results,
+	float *rotation_margins
+) const noexcept {
+	// Largest distance outside of any plane for the corner furthest along the plane normal (box
+	// is outside if positive) and for the opposite corner (box is entirely inside if not positive)
+	float outside_dists[box_batch_size], inside_dists[box_batch_size];
+	for (int i = 0; i < box_batch_size; ++i) outside_dists[i] = inside_dists[i] = -math::lims<float>::max();
+
+	// The corner used only depends on the plane, so the inner loops have no branches
+	for (const rel_plane &plane : rel_planes) {
+		const bool pos_x = plane.x > 0.0f, pos_y = plane.y > 0.0f, pos_z = plane.z > 0.0f;
+		const float *const far_x = pos_x ? boxes.max_x : boxes.min_x, *const near_x = pos_x ? boxes.min_x : boxes.max_x;
+		const float *const far_y = pos_y ? boxes.max_y : boxes.min_y, *const near_y = pos_y ? boxes.min_y : boxes.max_y;
+		const float *const far_z = pos_z ? boxes.max_z : boxes.min_z, *const near_z = pos_z ? boxes.min_z : boxes.max_z;
+
+		for (int i = 0; i < box_batch_size; ++i) {
+			const float far_dist = plane.distance - (plane.x * far_x[i] + plane.y * far_y[i] + plane.z * far_z[i]);
+			outside_dists[i] = math::max(outside_dists[i], far_dist);
+		}
+		if (!test_inside) continue;
+		for (int i = 0; i < box_batch_size; ++i) {
+			const float near_dist = plane.distance - (plane.x * near_x[i] + plane.y * near_y[i] + plane.z * near_z[i]);
+			inside_dists[i] = math::max(inside_dists[i], near_dist);
+		}
+	}
+
+	for (int i = 0; i < count; ++i) {
+		// All planes pass through (or extremely close to) the camera, so rotating the camera moves a plane by
+		// at most the distance to the furthest point of the box multiplied by how far the plane normal moved
+		const float box_x = math::max(math::abs(boxes.min_x[i]), math::abs(boxes.max_x[i]));
+		const float box_y = math::max(math::abs(boxes.min_y[i]), math::abs(boxes.max_y[i]));
+		const float box_z = math::max(math::abs(boxes.min_z[i]), math::abs(boxes.max_z[i]));
+		const float furthest_dist = ::sqrtf(box_x * box_x + box_y * box_y + box_z * box_z) + static_cast<float>(near_plane);
+
+		if (outside_dists[i] > 0.0f) {
+			// Stays outside until the furthest plane it is outside of moves past it
+			results[i] = box_outside;
+			rotation_margins[i] = outside_dists[i] / furthest_dist;
+		} else if (test_inside && inside_dists[i] <= 0.0f) {
+			results[i] = box_inside;
+			rotation_margins[i] = -inside_dists[i] / furthest_dist;
+		} else {
+			// Stays visible until the closest plane reaches it
+			results[i] = box_intersecting;
+			rotation_margins[i] = -outside_dists[i] / furthest_dist;
+		}
+	}
+}
+
+double camera_frustum::rotation_since(const camera_frustum &previous) const noexcept
+{
+	// Any unit vector v = a*front + b*up + c*right moves by at most (|a| + |c|) * front
+	// movement + (|b| + |c|) * up movement, which is below double their sum
+	return 2.0 * ((front - previous.front).length() + (up - previous.up).length());
+}
+
+bool camera_frustum::has_same_origin(const camera_frustum &previous) const noexcept
+{
+	return origin == previous.origin && fov == previous.fov && aspect == previous.aspect;
 }
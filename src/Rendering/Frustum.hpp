@@ -31,9 +31,36 @@ struct camera_frustum
 	) noexcept;
 	bool is_chunk_visible(const vector3d &corner) const noexcept;
 
+	// Axis-aligned boxes tested in batches, stored as a structure of arrays with float values
+	// relative to the camera so that each plane is tested against all boxes of a batch at once
+	static constexpr int box_batch_size = 8;
+	struct box_batch_obj { float min_x[box_batch_size], min_y[box_batch_size], min_z[box_batch_size],
+	                             max_x[box_batch_size], max_y[box_batch_size], max_z[box_batch_size]; };
+	enum box_result_en : uint8_t { box_outside, box_intersecting, box_inside };
+
+	// Also gives how far the camera can rotate (as a bound on how far any of its unit direction vectors can
+	// move) before each result could change, allowing results to be reused when looking around. Boxes are
+	// only reported as entirely inside if requested, in which case the margin is for staying inside.
+	void test_box_batch(
+		const box_batch_obj &boxes,
+		int count,
+		bool test_inside,
+		box_result_en *results,
+		float *rotation_margins
+	) const noexcept;
+
+	double rotation_since(const camera_frustum &previous) const noexcept;
+	bool has_same_origin(const camera_frustum &previous) const noexcept;
+
+	// Values used to create the current planes
+	vector3d origin, front, up, right;
+	double fov = 0.0;
+	float aspect = 0.0f;
+
 	// The 'far' plane would prevent rendering of chunks further away than it so
 	// it is not included in frustum checks. This also improves performance slightly.
 	frust_plane top_pl, near_pl, left_pl, right_pl, bottom_pl;
+	struct rel_plane { float x, y, z, distance; } rel_planes[5]; // Planes relative to the camera position
 };
 
 #endif // SOURCE_RENDERING_FRUSTUM_VXL_HDR
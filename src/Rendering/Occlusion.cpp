@@ -0,0 +1,157 @@
+#include "Occlusion.hpp"
+
+void occlusion_buffer_obj::begin(const camera_frustum &frustum, int parts_count) noexcept
+{
+	// Use the same view as the frustum to convert world positions into pixels
+	m_origin = frustum.origin;
+	m_front = frustum.front;
+	m_up = frustum.up;
+	m_right = frustum.right;
+
+	const double half_v_tan = ::tan(frustum.fov * 0.5);
+	m_y_scale = 0.5 / half_v_tan;
+	m_x_scale = 0.5 / (half_v_tan * static_cast<double>(frustum.aspect));
+
+	std::fill(m_depths, m_depths + (width * height), math::lims<float>::max()); // Nothing is covered yet
+	m_parts_count = math::max(parts_count, 1);
+	m_part_depths.resize(static_cast<size_t>(width * height) * static_cast<size_t>(m_parts_count - 1));
+}
+
+bool occlusion_buffer_obj::project(const vector3d &point, projected_obj *result) const noexcept
+{
+	// Points behind the near plane cannot be projected
+	const vector3d relative = point - m_origin;
+	const double depth = relative.dot(m_front);
+	if (depth < camera_frustum::near_plane) return false;
+
+	// Pixel coordinates with (0, 0) at the bottom left of the buffer
+	const double inv_depth = 1.0 / depth;
+	*result = {
+		static_cast<float>((0.5 + relative.dot(m_right) * inv_depth * m_x_scale) * width),
+		static_cast<float>((0.5 + relative.dot(m_up) * inv_depth * m_y_scale) * height),
+		static_cast<float>(depth)
+	};
+	return true;
+}
+
+void occlusion_buffer_obj::rasterize_part(const std::vector<box_obj> &occluders, int part) noexcept
+{
+	// The first part draws straight into the final buffer, which was already cleared
+	constexpr size_t pixels_count = static_cast<size_t>(width * height);
+	float *const depths = part ? m_part_depths.data() + (pixels_count * static_cast<size_t>(part - 1)) : m_depths;
+	if (part) std::fill(depths, depths + pixels_count, math::lims<float>::max());
+
+	const size_t parts_count = static_cast<size_t>(m_parts_count), part_ind = static_cast<size_t>(part);
+	const size_t end = (occluders.size() * (part_ind + 1u)) / parts_count;
+	for (size_t index = (occluders.size() * part_ind) / parts_count; index < end; ++index) rasterize_box(occluders[index], depths);
+}
+
+void occlusion_buffer_obj::merge_parts() noexcept
+{
+	// Keep the closest depth of every buffer
+	constexpr size_t pixels_count = static_cast<size_t>(width * height);
+	for (int part = 1; part < m_parts_count; ++part) {
+		const float *const depths = m_part_depths.data() + (pixels_count * static_cast<size_t>(part - 1));
+		for (size_t i = 0; i < pixels_count; ++i) m_depths[i] = math::min(m_depths[i], depths[i]);
+	}
+}
+
+void occlusion_buffer_obj::rasterize_box(const box_obj &box, float *depths) const noexcept
+{
+	// Corner indexes use bit 0 for X, bit 1 for Y and bit 2 for Z (set = max)
+	static constexpr int face_corners[6][4] = {
+		{ 1, 3, 7, 5 }, { 0, 4, 6, 2 }, // +X, -X
+		{ 2, 6, 7, 3 }, { 0, 1, 5, 4 }, // +Y, -Y
+		{ 4, 5, 7, 6 }, { 0, 2, 3, 1 }  // +Z, -Z
+	};
+
+	const vector3d corners[2] = { box.min, box.max };
+	const bool faces_camera[6] = {
+		m_origin.x > box.max.x, m_origin.x < box.min.x,
+		m_origin.y > box.max.y, m_origin.y < box.min.y,
+		m_origin.z > box.max.z, m_origin.z < box.min.z
+	};
+
+	// Only the faces pointing towards the camera are needed, as they cover the entire box
+	for (int face = 0; face < 6; ++face) {
+		if (!faces_camera[face]) continue;
+		projected_obj projected[4];
+		bool is_projected = true;
+		for (int i = 0; i < 4 && is_projected; ++i) {
+			const int corner = face_corners[face][i];
+			const vector3d point = { corners[corner & 1].x, corners[(corner >> 1) & 1].y, corners[(corner >> 2) & 1].z };
+			is_projected = project(point, projected + i);
+		}
+		if (is_projected) rasterize_quad(projected, depths);
+	}
+}
+
+void occlusion_buffer_obj::rasterize_quad(const projected_obj *corners, float *depths) const noexcept
+{
+	// Pixel range that could be covered by the quad
+	float min_x = corners[0].x, max_x = corners[0].x, min_y = corners[0].y, max_y = corners[0].y;
+	float furthest_depth = corners[0].depth;
+	for (int i = 1; i < 4; ++i) {
+		min_x = math::min(min_x, corners[i].x); max_x = math::max(max_x, corners[i].x);
+		min_y = math::min(min_y, corners[i].y); max_y = math::max(max_y, corners[i].y);
+		furthest_depth = math::max(furthest_depth, corners[i].depth);
+	}
+
+	const int start_x = math::max(0, static_cast<int>(::floorf(min_x))), end_x = math::min(width, static_cast<int>(::ceilf(max_x)));
+	const int start_y = math::max(0, static_cast<int>(::floorf(min_y))), end_y = math::min(height, static_cast<int>(::ceilf(max_y)));
+	if (start_x >= end_x || start_y >= end_y) return;
+
+	// Edge equations facing inwards (the winding depends on which side the quad is seen from)
+	float edge_a[4], edge_b[4], edge_c[4];
+	const float winding = ((corners[1].x - corners[0].x) * (corners[2].y - corners[0].y)) -
+	                      ((corners[1].y - corners[0].y) * (corners[2].x - corners[0].x)) < 0.0f ? -1.0f : 1.0f;
+	for (int i = 0; i < 4; ++i) {
+		const projected_obj &from = corners[i], &to = corners[(i + 1) & 3];
+		edge_a[i] = (from.y - to.y) * winding;
+		edge_b[i] = (to.x - from.x) * winding;
+		// Subtract the furthest any corner of a pixel is from its center, so the whole pixel needs to be inside
+		edge_c[i] = -(edge_a[i] * from.x + edge_b[i] * from.y) - 0.5f * (math::abs(edge_a[i]) + math::abs(edge_b[i]));
+	}
+
+	for (int y = start_y; y < end_y; ++y) {
+		const float center_y = static_cast<float>(y) + 0.5f;
+		float *const row = depths + (y * width);
+		for (int x = start_x; x < end_x; ++x) {
+			const float center_x = static_cast<float>(x) + 0.5f;
+			bool is_inside = true;
+			for (int i = 0; i < 4; ++i) is_inside &= edge_a[i] * center_x + edge_b[i] * center_y + edge_c[i] >= 0.0f;
+			if (is_inside) row[x] = math::min(row[x], furthest_depth);
+		}
+	}
+}
+
+bool occlusion_buffer_obj::is_box_occluded(const vector3d &box_min, const vector3d &box_max) const noexcept
+{
+	// Find the pixels the box could cover and its closest depth
+	float min_x = math::lims<float>::max(), max_x = -min_x, min_y = min_x, max_y = -min_x, closest_depth = min_x;
+	for (int corner = 0; corner < 8; ++corner) {
+		projected_obj projected;
+		const vector3d point = {
+			corner & 1 ? box_max.x : box_min.x,
+			corner & 2 ? box_max.y : box_min.y,
+			corner & 4 ? box_max.z : box_min.z
+		};
+		if (!project(point, &projected)) return false; // Too close to be hidden
+		min_x = math::min(min_x, projected.x); max_x = math::max(max_x, projected.x);
+		min_y = math::min(min_y, projected.y); max_y = math::max(max_y, projected.y);
+		closest_depth = math::min(closest_depth, projected.depth);
+	}
+
+	// Parts of the box outside of the buffer are unknown, so it can only be hidden if it is entirely inside.
+	// As a result, a hidden box stays hidden when the camera only rotates, since the same rays are blocked.
+	const int start_x = static_cast<int>(::floorf(min_x)), end_x = static_cast<int>(::ceilf(max_x));
+	const int start_y = static_cast<int>(::floorf(min_y)), end_y = static_cast<int>(::ceilf(max_y));
+	if (start_x < 0 || start_y < 0 || end_x > width || end_y > height) return false;
+
+	// Every pixel needs to have an occluder in front of the box
+	for (int y = start_y; y < end_y; ++y) {
+		const float *const row = m_depths + (y * width);
+		for (int x = start_x; x < end_x; ++x) if (row[x] >= closest_depth) return false;
+	}
+	return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#ifndef SOURCE_RENDERING_OCCLUSION_VXL_HDR
+#define SOURCE_RENDERING_OCCLUSION_VXL_HDR
+
+#include "Rendering/Frustum.hpp"
+
+// Low resolution depth buffer filled on the CPU with large solid boxes (such as fully opaque subchunks),
+// used to skip chunks that are completely hidden behind them. Occluders only cover pixels they cover
+// entirely with their furthest depth and tests use the closest depth of a box, so results are conservative.
+class occlusion_buffer_obj
+{
+public:
+	static constexpr int width = 128, height = 64;
+	struct box_obj { vector3d min, max; };
+
+	// Occluders can be drawn in parts on separate threads, each into its own buffer, which are then combined
+	void begin(const camera_frustum &frustum, int parts_count) noexcept;
+	void rasterize_part(const std::vector<box_obj> &occluders, int part) noexcept;
+	void merge_parts() noexcept;
+	bool is_box_occluded(const vector3d &box_min, const vector3d &box_max) const noexcept;
+	
+	const float *get_depths() const noexcept { return m_depths; }
+private:
+	struct projected_obj { float x, y, depth; };
+	bool project(const vector3d &point, projected_obj *result) const noexcept;
+	void rasterize_box(const box_obj &box, float *depths) const noexcept;
+	void rasterize_quad(const projected_obj *corners, float *depths) const noexcept;
+
+	vector3d m_origin, m_front, m_up, m_right;
+	double m_x_scale, m_y_scale;
+
+	float m_depths[width * height];
+	std::vector<float> m_part_depths; // Separate buffer for each part after the first
+	int m_parts_count = 1;
+};
+
+#endif // SOURCE_RENDERING_OCCLUSION_VXL_HDR
@@ -52,14 +52,32 @@ void world_chunk::construct_blocks(const noise_object::block_noise *perlin_ptr,
 
 void world_chunk::mesh_faces(
 	const world_map &chunks_map,
-	const world_full_chunk *,
+	const world_full_chunk *full_chunk,
 	const world_xzpos *const xz_offset,
 	face_counts_obj *const result_counters,
 	pos_t y_offset,
-	quad_data_t *const quads_results_ptr
+	quad_data_t *const quads_results_ptr,
+	uint32_t lod_key
 ) {
+	::memset(result_counters, 0, sizeof(face_counts_obj[6])); // Reset counters of any previous mesh
+	update_visibility_info();
 	if (!blocks) return; // Don't calculate air chunks
 	::memset(&quads_ptr, 0, sizeof quads_ptr); // Reset all quad data
+
+	// Adjacent full chunks are needed for skirts as well as lower detail meshes
+	const world_full_chunk *nearby_full_chunks[4];
+	for (int i = 0; i < 4; ++i) {
+		const auto it = chunks_map.find(*xz_offset + chunk_vals::dirs_xz[i]);
+		nearby_full_chunks[i] = it != chunks_map.end() ? it->second : nullptr;
+	}
+
+	const int lod_level = static_cast<int>(lod_key & world_full_chunk::lod_level_mask);
+	const unsigned skirt_dirs = lod_key >> world_full_chunk::lod_skirts_shift;
+	if (lod_level) {
+		mesh_lod_faces(full_chunk, nearby_full_chunks, result_counters, y_offset, lod_level, skirt_dirs, quads_results_ptr);
+		compress_quads(result_counters, quads_results_ptr);
+		return;
+	}
 	
 	const block_id *const block_start_ptr = blocks[0][0][0]; // Use 1D array access instead of 3D for speed
 
@@ -75,16 +93,11 @@ void world_chunk::mesh_faces(
 	if (y_offset && this[-1].blocks) nearby_ptrs[wdir_down] = this[-1].blocks[0][0][0];
 	if (y_offset != chunk_vals::top_y_ind && this[1].blocks) nearby_ptrs[wdir_up] = this[1].blocks[0][0][0];
 
-	// Get nearby chunks
+	// Add possible adjacent chunks if they have valid blocks
 	for (int i = 0; i < 4; ++i) {
-		const world_xzpos new_offset = *xz_offset + chunk_vals::dirs_xz[i]; // Calculate nearby XZ offset
- 		const auto it = chunks_map.find(new_offset); // Look for a full chunk struct with the calculate offset
-		// Add possible adjacent chunk if one is found with valid blocks
-		if (it != chunks_map.end() && it->second->subchunks[y_offset].blocks)
-		nearby_ptrs[i + ((i >= wdir_up) * 2)] =
-		        it != chunks_map.end() && it->second->subchunks[y_offset].blocks ?
-		              it->second->subchunks[y_offset].blocks[0][0][0] :
-		              nullptr;
+		const world_full_chunk *const nearby_full_chunk = nearby_full_chunks[i];
+		if (nearby_full_chunk && nearby_full_chunk->subchunks[y_offset].blocks)
+			nearby_ptrs[i + ((i >= wdir_up) * 2)] = nearby_full_chunk->subchunks[y_offset].blocks[0][0][0];
 	}
 
 	// Saved lookup data and chunk indexes
@@ -112,31 +125,182 @@ void world_chunk::mesh_faces(
 				curr_mesh_data,
 				block_properties::mesh_of_block(block_ptr ? block_ptr[lookup_int >> 3] : block_id::air)
 			)) continue;
-			// Compress the position and texture data into one integer
-			// Layout: TTTT TTTT TTTT TTTT TZZZ ZZYY YYYX XXXX
 			const uint32_t z_pos = block_index % chunk_vals::size;
 			const uint32_t x_pos = (block_index / chunk_vals::squared);
 			const uint32_t y_pos = (block_index / chunk_vals::size) % chunk_vals::size;
 
-			const quad_data_t quad_data = 
-			    x_pos + (y_pos << chunk_vals::size_bits) + (z_pos << (chunk_vals::size_bits * 2)) + // Position in chunk
-			    (static_cast<uint32_t>(curr_attributes->textures[i]) << (chunk_vals::size_bits * 3)); // Texture
-
-			// Blocks with transparency need to be rendered last for them to be rendered
-			// correctly on top of existing terrain, so they can be placed starting from
-			// the end of the data array instead to be separated from the opaque blocks.
-			
-			// For translucent faces, set the data in reverse order, starting from the end of
-			// the array (pre-increment to avoid writing to out of bounds the first time).
-			// If it is a normal face however, just add to the array normally.
-			face_counts_obj *const face_dir_counter = result_counters + i;
-			quads_results_ptr[(curr_mesh_data->has_trnsp ?
-				chunk_vals::blocks_count - ++face_dir_counter->translucent_count :
-				face_dir_counter->opaque_count++) + (i * chunk_vals::blocks_count)
-			] = quad_data;
+			add_face(result_counters, quads_results_ptr, i, x_pos, y_pos, z_pos, y_offset, curr_attributes);
 		}
 	}
 
+	// Faces against the adjacent full chunks using a different level of detail are also added wherever
+	// its surface is, so the different meshes of the two never leave a gap between them
+	for (int i = 0; i < 6; ++i) {
+		if (i == wdir_up || i == wdir_down) continue;
+		const int nearby_ind = i - ((i >= wdir_up) * 2);
+		const world_full_chunk *const nearby_full_chunk = nearby_full_chunks[nearby_ind];
+		if (!(skirt_dirs & (1u << nearby_ind)) || !nearby_full_chunk) continue;
+
+		for (int y = 0; y < chunk_vals::size; ++y) {
+			for (int side = 0; side < chunk_vals::size; ++side) {
+				const world_pos border_pos = i < wdir_up ?
+					world_pos{ i == wdir_right ? chunk_vals::less : 0, y, side } :
+					world_pos{ side, y, i == wdir_front ? chunk_vals::less : 0 };
+				const world_pos nearby_pos = border_pos + chunk_vals::dirs_xyz[i] - (chunk_vals::dirs_xyz[i] * chunk_vals::size);
+
+				const block_id curr_block_id = (*blocks)[border_pos.x][border_pos.y][border_pos.z];
+				if (curr_block_id == block_id::air) continue;
+				const block_properties::block_attributes *const curr_attributes = block_properties::of_block(curr_block_id);
+				const block_id nearby_block_id = lod_cell_block(nearby_full_chunk, y_offset, nearby_pos, 0);
+
+				// Only the faces that were hidden by a block at the surface of the adjacent chunk
+				if (curr_attributes->visible_with(&curr_attributes->mesh_info, block_properties::mesh_of_block(nearby_block_id))) continue;
+				if (lod_cell_block(nearby_full_chunk, y_offset, nearby_pos + world_pos{ 0, 1, 0 }, 0) != block_id::air) continue;
+				add_face(result_counters, quads_results_ptr, i,
+					static_cast<uint32_t>(border_pos.x), static_cast<uint32_t>(border_pos.y), static_cast<uint32_t>(border_pos.z),
+					y_offset, curr_attributes
+				);
+			}
+		}
+	}
+
+	compress_quads(result_counters, quads_results_ptr);
+}
+
+void world_chunk::mesh_lod_faces(
+	const world_full_chunk *full_chunk,
+	const world_full_chunk *const *nearby_full_chunks,
+	face_counts_obj *const result_counters,
+	pos_t y_offset,
+	int lod_level,
+	unsigned skirt_dirs,
+	quad_data_t *const quads_results_ptr
+) const noexcept {
+	// Each cell of (2^level) blocks on each side becomes a single block, so faces are only added between cells.
+	// Every cell is voted once into a grid with a border of one cell taken from the adjacent full chunks and
+	// subchunks, so each block is only read once however many faces and skirts look at its cell
+	const int cells_count = chunk_vals::size >> lod_level, grid_side = cells_count + 2;
+	constexpr int max_grid_side = (chunk_vals::size >> 1) + 2;
+	block_id cell_grid[max_grid_side * max_grid_side * max_grid_side];
+	const auto grid_ind = [&](const world_pos &cell_pos) noexcept {
+		return ((cell_pos.x + 1) * grid_side + (cell_pos.y + 1)) * grid_side + (cell_pos.z + 1);
+	};
+
+	// Cells of this subchunk, along with the layers of cells below and above it
+	for (int x = 0; x < cells_count; ++x) for (int y = -1; y <= cells_count; ++y) for (int z = 0; z < cells_count; ++z) {
+		const world_pos cell_pos = { x, y, z };
+		cell_grid[grid_ind(cell_pos)] = lod_cell_block(full_chunk, y_offset, cell_pos, lod_level);
+	}
+
+	// Cells of the adjacent full chunks next to each side (corner columns are never compared against)
+	for (int i = 0; i < 6; ++i) {
+		if (i == wdir_up || i == wdir_down) continue;
+		const world_full_chunk *const nearby_full_chunk = nearby_full_chunks[i - ((i >= wdir_up) * 2)];
+		const world_pos &dir = chunk_vals::dirs_xyz[i];
+		const pos_t border = (dir.x + dir.z) > 0 ? cells_count : -1;
+
+		for (int y = -1; y <= cells_count; ++y) for (int side = 0; side < cells_count; ++side) {
+			const world_pos cell_pos = dir.x ? world_pos{ border, y, side } : world_pos{ side, y, border };
+			cell_grid[grid_ind(cell_pos)] = nearby_full_chunk ?
+				lod_cell_block(nearby_full_chunk, y_offset, cell_pos - (dir * cells_count), lod_level) :
+				block_id::air;
+		}
+	}
+
+	for (int x = 0; x < cells_count; ++x) for (int y = 0; y < cells_count; ++y) for (int z = 0; z < cells_count; ++z) {
+		const world_pos cell_pos = { x, y, z };
+		const block_id curr_block_id = cell_grid[grid_ind(cell_pos)];
+		if (curr_block_id == block_id::air) continue;
+		const block_properties::block_attributes *const curr_attributes = block_properties::of_block(curr_block_id);
+
+		for (int i = 0; i < 6; ++i) {
+			const world_pos nearby_pos = cell_pos + chunk_vals::dirs_xyz[i];
+			const block_id nearby_block_id = cell_grid[grid_ind(nearby_pos)];
+			if (!curr_attributes->visible_with(&curr_attributes->mesh_info, block_properties::mesh_of_block(nearby_block_id))) {
+				// Skirt against the surface of an adjacent chunk using a different level of detail
+				if (nearby_pos.x >= 0 && nearby_pos.x < cells_count && nearby_pos.z >= 0 && nearby_pos.z < cells_count) continue;
+				const int nearby_ind = i - ((i >= wdir_up) * 2);
+				if (!(skirt_dirs & (1u << nearby_ind)) || !nearby_full_chunks[nearby_ind]) continue;
+				if (cell_grid[grid_ind(nearby_pos + world_pos{ 0, 1, 0 })] != block_id::air) continue;
+			}
+
+			add_face(result_counters, quads_results_ptr, i,
+				static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(z), y_offset, curr_attributes
+			);
+		}
+	}
+}
+
+block_id world_chunk::lod_cell_block(const world_full_chunk *full_chunk, pos_t y_offset, world_pos cell_pos, int lod_level) noexcept
+{
+	// Cells above or below this subchunk are in the adjacent ones
+	const int cells_count = chunk_vals::size >> lod_level;
+	if (cell_pos.y < 0) { --y_offset; cell_pos.y += cells_count; }
+	else if (cell_pos.y >= cells_count) { ++y_offset; cell_pos.y -= cells_count; }
+	if (y_offset < 0 || y_offset >= chunk_vals::y_count) return block_id::air;
+
+	const chunk_vals::blocks_array *const cell_blocks = full_chunk->subchunks[y_offset].blocks;
+	if (!cell_blocks) return block_id::air;
+	if (!lod_level) return (*cell_blocks)[cell_pos.x][cell_pos.y][cell_pos.z];
+
+	// The cell is filled if at least half of its blocks are, using the most common of the highest
+	// blocks in each column of the cell so the surface keeps its appearance (e.g. grass over dirt)
+	const int cell_size = 1 << lod_level;
+	const world_pos start = cell_pos * cell_size;
+	uint8_t votes[static_cast<int>(block_id::blocks_count)] = {};
+	block_id top_block_id = block_id::air;
+	int top_votes = 0, filled_count = 0;
+
+	for (pos_t x = start.x; x < start.x + cell_size; ++x) for (pos_t z = start.z; z < start.z + cell_size; ++z) {
+		bool is_top_found = false;
+		for (pos_t y = start.y + cell_size - 1; y >= start.y; --y) {
+			const block_id curr_block_id = (*cell_blocks)[x][y][z];
+			if (curr_block_id == block_id::air) continue;
+			++filled_count;
+			if (is_top_found) continue;
+			is_top_found = true;
+
+			const int curr_votes = ++votes[static_cast<int>(curr_block_id)];
+			if (curr_votes > top_votes) { top_votes = curr_votes; top_block_id = curr_block_id; }
+		}
+	}
+
+	return filled_count * 2 < cell_size * cell_size * cell_size ? block_id::air : top_block_id;
+}
+
+void world_chunk::add_face(
+	face_counts_obj *const result_counters,
+	quad_data_t *const quads_results_ptr,
+	int face_ind,
+	uint32_t x_pos,
+	uint32_t y_pos,
+	uint32_t z_pos,
+	pos_t y_offset,
+	const block_properties::block_attributes *attributes
+) noexcept {
+	// Compress the position, subchunk index and texture data into one integer
+	// Layout: TTTT TTTT TTTT TTSS SZZZ ZZYY YYYX XXXX
+	const quad_data_t quad_data = 
+	    x_pos + (y_pos << chunk_vals::size_bits) + (z_pos << (chunk_vals::size_bits * 2)) + // Position in chunk
+	    (static_cast<uint32_t>(y_offset) << (chunk_vals::size_bits * 3)) + // Subchunk in the full chunk
+	    (static_cast<uint32_t>(attributes->textures[face_ind]) << chunk_vals::texture_shift); // Texture
+
+	// Blocks with transparency need to be rendered last for them to be rendered
+	// correctly on top of existing terrain, so they can be placed starting from
+	// the end of the data array instead to be separated from the opaque blocks.
+	
+	// For translucent faces, set the data in reverse order, starting from the end of
+	// the array (pre-increment to avoid writing to out of bounds the first time).
+	// If it is a normal face however, just add to the array normally.
+	face_counts_obj *const face_dir_counter = result_counters + face_ind;
+	quads_results_ptr[(attributes->mesh_info.has_trnsp ?
+		chunk_vals::blocks_count - ++face_dir_counter->translucent_count :
+		face_dir_counter->opaque_count++) + (face_ind * chunk_vals::blocks_count)
+	] = quad_data;
+}
+
+void world_chunk::compress_quads(const face_counts_obj *const result_counters, const quad_data_t *const quads_results_ptr)
+{
 	// Remove possible gap between the two face counters for each 'chunk face'
 	for (int face_ind = 0; face_ind < 6; ++face_ind) {
 		const face_counts_obj *const face_dir_counter = result_counters + face_ind;
@@ -166,6 +330,81 @@ void world_chunk::mesh_faces(
 	}
 }
 
+int world_chunk::face_pair_bit(int first_face, int second_face) noexcept
+{
+	// Index into the 15 unordered pairs of different faces
+	static constexpr int8_t pair_bits[6][6] = {
+		{ -1,  0,  1,  2,  3,  4 },
+		{  0, -1,  5,  6,  7,  8 },
+		{  1,  5, -1,  9, 10, 11 },
+		{  2,  6,  9, -1, 12, 13 },
+		{  3,  7, 10, 12, -1, 14 },
+		{  4,  8, 11, 13, 14, -1 }
+	};
+	return pair_bits[first_face][second_face];
+}
+
+void world_chunk::update_visibility_info() noexcept
+{
+	// Air chunks can be seen through in any direction
+	is_opaque_fill = false;
+	face_connections = all_face_connections;
+	if (!blocks) return;
+
+	const block_id *const block_start_ptr = blocks[0][0][0];
+	const auto is_see_through = [&](uint32_t block_index) {
+		return block_properties::mesh_of_block(block_start_ptr[block_index])->has_trnsp;
+	};
+
+	// Flood fill each group of connected non-opaque blocks, noting every chunk face the group reaches
+	bool is_visited[chunk_vals::blocks_count] = {};
+	uint16_t fill_stack[chunk_vals::blocks_count];
+	face_connections = 0u;
+	int see_through_count = 0;
+
+	for (uint32_t first_index = 0; first_index < chunk_vals::blocks_count; ++first_index) {
+		if (is_visited[first_index] || !is_see_through(first_index)) continue;
+		is_visited[first_index] = true;
+		fill_stack[0] = static_cast<uint16_t>(first_index);
+		int stack_size = 1, reached_faces = 0;
+
+		while (stack_size) {
+			const uint32_t block_index = fill_stack[--stack_size];
+			++see_through_count;
+
+			// Same layout as meshing - Z changes first, then Y, then X
+			const uint32_t z_pos = block_index % chunk_vals::size;
+			const uint32_t y_pos = (block_index / chunk_vals::size) % chunk_vals::size;
+			const uint32_t x_pos = block_index / chunk_vals::squared;
+			const uint32_t positions[3] = { x_pos, y_pos, z_pos };
+			constexpr uint32_t axis_steps[3] = { chunk_vals::squared, chunk_vals::size, 1u };
+
+			for (int axis = 0; axis < 3; ++axis) {
+				// Faces are ordered as positive then negative direction of each axis
+				for (int is_negative = 0; is_negative < 2; ++is_negative) {
+					const bool is_at_edge = is_negative ? positions[axis] == 0u : positions[axis] == chunk_vals::size - 1u;
+					if (is_at_edge) { reached_faces |= 1 << (axis * 2 + is_negative); continue; }
+
+					const uint32_t next_index = is_negative ? block_index - axis_steps[axis] : block_index + axis_steps[axis];
+					if (is_visited[next_index] || !is_see_through(next_index)) continue;
+					is_visited[next_index] = true;
+					fill_stack[stack_size++] = static_cast<uint16_t>(next_index);
+				}
+			}
+		}
+
+		// Every pair of faces reached by this group can see each other
+		for (int first_face = 0; first_face < 6; ++first_face) {
+			if (!(reached_faces & (1 << first_face))) continue;
+			for (int second_face = first_face + 1; second_face < 6; ++second_face) {
+				if (reached_faces & (1 << second_face)) face_connections |= static_cast<uint16_t>(1u << face_pair_bit(first_face, second_face));
+			}
+		}
+	}
+
+	is_opaque_fill = !see_through_count;
+}
+
 chunk_vals::blocks_array *world_chunk::allocate_blocks()
 {
 	// Allocate memory for chunk blocks array if it does not already exist
@@ -173,5 +412,36 @@ chunk_vals::blocks_array *world_chunk::allocate_blocks()
 	return blocks = static_cast<chunk_vals::blocks_array*>(::calloc(1, sizeof *blocks));
 }
 
+uint32_t world_full_chunk::next_version() noexcept
+{
+	// Global counter so a full chunk created at a previously used offset never matches an older version
+	static std::atomic<uint32_t> version_counter{ 0u };
+	return ++version_counter; // First version is 1 as 0 signifies a missing chunk
+}
+
+void world_full_chunk::update_geometry_summary() noexcept
+{
+	geometry_start_y = geometry_end_y = 0;
+	opaque_fill_mask = 0;
+
+	for (pos_t y_offset = 0; y_offset < chunk_vals::y_count; ++y_offset) {
+		const world_chunk &chunk = subchunks[y_offset];
+		if (chunk.is_opaque_fill) opaque_fill_mask |= static_cast<uint8_t>(1u << y_offset);
+
+		uint32_t total_faces = 0;
+		for (const world_chunk::face_counts_obj &counters : chunk.face_counters) total_faces += counters.total_faces();
+		if (!total_faces && !chunk.resident_count && !(chunk.state & world_chunk::states_en::needs_upload)) continue;
+
+		if (geometry_start_y == geometry_end_y) geometry_start_y = y_offset;
+		geometry_end_y = y_offset + 1;
+	}
+}
+
 // Delete block array in all chunks
-world_full_chunk::~world_full_chunk() { for (world_chunk &chunk : subchunks) if (chunk.blocks) ::free(chunk.blocks); }
+world_full_chunk::~world_full_chunk()
+{
+	for (world_chunk &chunk : subchunks) {
+		if (chunk.blocks) ::free(chunk.blocks);
+		delete[] chunk.resident_quads;
+	}
+}
@@ -4,6 +4,7 @@
 
 #include "World/Generation/Perlin.hpp"
 #include "World/Generation/Settings.hpp"
+#include "Rendering/BufferAllocator.hpp"
 
 struct world_full_chunk;
 
@@ -14,7 +15,10 @@ public:
 	chunk_vals::blocks_array *blocks = nullptr;
 	
 	quad_data_t *quads_ptr[6];
-	uint32_t glob_data_inds[6];
+	uint32_t glob_data_inds[6], glob_translucent_inds[6]; // Opaque and translucent faces of each direction in the instance buffer
+	buffer_allocator_obj::range_obj inst_range{}; // Range containing every face in the instance buffer (unused in the column layout)
+	quad_data_t *resident_quads = nullptr; // Copy of the uploaded faces, so they never need to be read back
+	uint32_t resident_count = 0; // Number of quads in the above copy
 	struct face_counts_obj {
 		uint32_t opaque_count, translucent_count;
 		inline uint32_t total_faces() const noexcept { return opaque_count + translucent_count; }
@@ -24,11 +28,21 @@ public:
 	std::vector<structure_info> structures;
 	enum states_en : uint8_t {
 		has_data_before = 1,
-		use_tmp_data = 2
+		needs_upload = 2
 	};
 	uint8_t state = 0;
+	bool is_opaque_fill = false; // Every block is opaque, so it can hide chunks behind it
+
+	// Each bit is set if two faces of the chunk are connected by non-opaque blocks (15 pairs of the 6 faces)
+	static constexpr uint16_t all_face_connections = 0x7FFFu;
+	uint16_t face_connections = all_face_connections;
+	static int face_pair_bit(int first_face, int second_face) noexcept;
+	inline bool are_faces_connected(int first_face, int second_face) const noexcept {
+		return face_connections & (1u << face_pair_bit(first_face, second_face));
+	}
 
 	chunk_vals::blocks_array *allocate_blocks();
+	void update_visibility_info() noexcept;
 	void construct_blocks(const noise_object::block_noise *perlin_list, int local_y_offset);
 	void mesh_faces(
 		const world_map &chunks_map,
@@ -36,14 +50,65 @@ public:
 		const world_xzpos *const xz_offset,
 		face_counts_obj *const result_counters,
 		pos_t y_offset,
-		quad_data_t *const quads_results_ptr
+		quad_data_t *const quads_results_ptr,
+		uint32_t lod_key = 0u
 	);
+
+	static block_id lod_cell_block(const world_full_chunk *full_chunk, pos_t y_offset, world_pos cell_pos, int lod_level) noexcept;
+private:
+	void mesh_lod_faces(
+		const world_full_chunk *full_chunk,
+		const world_full_chunk *const *nearby_full_chunks,
+		face_counts_obj *const result_counters,
+		pos_t y_offset,
+		int lod_level,
+		unsigned skirt_dirs,
+		quad_data_t *const quads_results_ptr
+	) const noexcept;
+	static void add_face(
+		face_counts_obj *const result_counters,
+		quad_data_t *const quads_results_ptr,
+		int face_ind,
+		uint32_t x_pos,
+		uint32_t y_pos,
+		uint32_t z_pos,
+		pos_t y_offset,
+		const block_properties::block_attributes *attributes
+	) noexcept;
+	void compress_quads(const face_counts_obj *const result_counters, const quad_data_t *const quads_results_ptr);
 };
 
 struct world_full_chunk {
 	enum state_en : uint8_t { generation_mark = 1 };
+
+	// Level of detail of a mesh (cells of 2^level blocks on each side are meshed as one block) in the lowest bits,
+	// followed by a bit for each adjacent full chunk using a different level that needs skirts to cover any gaps
+	static constexpr uint32_t lod_level_mask = 3u, lod_skirts_shift = 2u;
+
+	// Versions of this and the 4 adjacent full chunks (0 if not present) and the detail when this was last meshed
+	struct mesh_key_obj {
+		uint32_t versions[5];
+		uint32_t lod_key;
+		bool operator==(const mesh_key_obj &other) const noexcept {
+			return !::memcmp(versions, other.versions, sizeof versions) && lod_key == other.lod_key;
+		}
+	} mesh_key{};
+
+	uint32_t version = next_version(); // Changed whenever any of the blocks are edited
 	uint8_t full_state = 0;
+	bool is_layout_changed = false; // Resident quads need to be uploaded again (separate as the generation thread sets the state)
 	world_chunk subchunks[chunk_vals::y_count];
+	buffer_allocator_obj::range_obj inst_range{}; // Faces of every subchunk when using the column layout
+
+	// Range of subchunks that have faces, still own buffer data or are waiting to be uploaded, so air
+	// and buried subchunks are not visited when updating buffers (updated whenever a mesh is committed)
+	pos_t geometry_start_y = 0, geometry_end_y = 0;
+	uint8_t opaque_fill_mask = 0; // Bit for each fully opaque subchunk
+	void update_geometry_summary() noexcept;
+
+	inline void mark_changed() noexcept { version = next_version(); }
+	inline bool has_been_meshed() const noexcept { return mesh_key.versions[0] != 0u; }
+	static uint32_t next_version() noexcept;
 	~world_full_chunk();
 };
 
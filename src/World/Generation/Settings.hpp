@@ -209,6 +209,9 @@ namespace chunk_vals
 	constexpr float half = size / 2.0f;
 	constexpr int size_bits = math::bits(less);
 	constexpr int full_bits = ((~0u) >> ((sizeof(GLuint) * CHAR_BIT) - size_bits));
+	constexpr int y_count_bits = math::bits(top_y_ind); // Bits needed for the subchunk index in a full chunk
+	constexpr int y_full_bits = ((~0u) >> ((sizeof(GLuint) * CHAR_BIT) - y_count_bits));
+	constexpr int texture_shift = (size_bits * 3) + y_count_bits; // Texture bits start after the position in quad data
 	
 	constexpr int32_t squared = static_cast<int32_t>(size) * size;
 	constexpr int32_t blocks_count = squared * size;
@@ -284,6 +287,8 @@ namespace val_limits
 	template<typename T> struct lim_vec { T min, max; };
 	constexpr lim_vec<double> fov_limits  = { 20.0, 120.0 };
 	constexpr lim_vec<int32_t> render_limits  = { 4, 200 };
+	constexpr lim_vec<int32_t> unload_band_limits = { 0, 8 };
+	constexpr lim_vec<double> dwell_limits = { 0.0, 5.0 };
 	constexpr lim_vec<double> tick_limits = { -200.0, 200.0 };
 }
 
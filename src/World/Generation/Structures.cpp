@@ -2,20 +2,44 @@
 
 void world_obj::world_chunk_generator::generate_surrounding(
 	const world_xzpos *curr_xz_offset,
-	int32_t curr_rnd_dist
+	int32_t curr_rnd_dist,
+	const vector2f *const view_dir,
+	uint32_t gen_epoch
 ) noexcept {
 	const int32_t search_dist = curr_rnd_dist + 2;
-	const size_t crd_line = static_cast<size_t>((search_dist * 2) + 1);
-	const size_t total_pos_checks = crd_line * crd_line;
-
-	thread_ops::split(game.generation_thread_count, total_pos_checks, [&](int, size_t index, size_t end) {
-		for (; index < end && game.is_active; ++index) {
-			const int x_ind = static_cast<int>(index % crd_line) - search_dist;
-			const int z_ind = static_cast<int>(index / crd_line) - search_dist;
-			if (math::abs(x_ind) + math::abs(z_ind) > search_dist) continue;
-			const world_xzpos full_chunk_xz_offset = { curr_xz_offset->x + x_ind, curr_xz_offset->y + z_ind };
-			gen_full_chunk(&full_chunk_xz_offset);
+
+	// Create a list of every offset in the generation 'diamond', nearest first
+	if (search_dist != gen_order_dist) {
+		gen_order.clear();
+		for (int x = -search_dist; x <= search_dist; ++x) {
+			const int z_dist = search_dist - math::abs(x);
+			for (int z = -z_dist; z <= z_dist; ++z) gen_order.emplace_back(gen_order_obj{ { x, z }, 0.0f });
 		}
+		std::sort(gen_order.begin(), gen_order.end(), [](const gen_order_obj &a, const gen_order_obj &b) {
+			return math::abs(a.offset.x) + math::abs(a.offset.y) < math::abs(b.offset.x) + math::abs(b.offset.y);
+		});
+		gen_order_dist = search_dist;
+	}
+
+	// Chunks in front of the camera are treated as closer and those behind as further away
+	for (gen_order_obj &entry : gen_order) {
+		const vector2f rel_offset = { static_cast<float>(entry.offset.x), static_cast<float>(entry.offset.y) };
+		const float length = rel_offset.length();
+		const float facing = length > 0.0f ? rel_offset.dot(*view_dir) / length : 0.0f;
+		entry.priority = static_cast<float>(math::abs(entry.offset.x) + math::abs(entry.offset.y)) *
+		                 (1.0f - (view_priority_bias * facing));
+	}
+	std::stable_sort(gen_order.begin(), gen_order.end(), [](const gen_order_obj &a, const gen_order_obj &b) {
+		return a.priority < b.priority;
+	});
+
+	// Workers take the next chunk in priority order
+	const gen_order_obj *const order_ptr = gen_order.data();
+	thread_ops::split_ordered(game.generation_thread_count, gen_order.size(), [&](int, size_t index) {
+		if (!game.is_active) return;
+		const world_xzpos full_chunk_xz_offset = *curr_xz_offset + order_ptr[index].offset;
+		if (world->is_outside_gen_target(&full_chunk_xz_offset, 2, gen_epoch)) return; // Player has moved away
+		gen_full_chunk(&full_chunk_xz_offset);
 	});
 }
 
@@ -66,29 +90,31 @@ world_obj::world_chunk_generator::full_chunk_result world_obj::world_chunk_gener
 	return full_chunk_result{ full_chunk, noise_table };
 }
 
-world_chunk *world_obj::world_chunk_generator::create_or_get_chunk(const world_pos *const offset)
+world_full_chunk *world_obj::world_chunk_generator::create_or_get_full_chunk(const world_xzpos *const xz_offset)
 {
-	world_chunk *chunk = get_chunk(offset);
-	if (chunk) return chunk;
-	const world_xzpos xz_offset = offset->xz();
-	return create_full_chunk(&xz_offset).full_chunk->subchunks + offset->y;
+	world_full_chunk *full_chunk = get_full_chunk(xz_offset);
+	return full_chunk ? full_chunk : create_full_chunk(xz_offset).full_chunk;
 }
 
-world_chunk *world_obj::world_chunk_generator::get_chunk(const world_pos *const offset)
+world_full_chunk *world_obj::world_chunk_generator::get_full_chunk(const world_xzpos *const xz_offset)
 {
 	decltype(reserved_map)::iterator found; // Use mutex in case reserved map is being edited right now
 	{
 		std::lock_guard<std::mutex> reserved_find_guard(reserved_access_mutex);
-		found = reserved_map.find(offset->xz());
+		found = reserved_map.find(*xz_offset);
 	}
-	return found == reserved_map.end() ? nullptr : found->second->subchunks + offset->y;
+	return found == reserved_map.end() ? nullptr : found->second;
 }
 
 
-block_id &world_obj::world_chunk_generator::create_block_ref(const world_pos *const position)
+block_id &world_obj::world_chunk_generator::create_block_ref(const world_pos *const position, bool is_changing)
 {
 	const world_pos offset = chunk_vals::world_to_offset(position);
-	world_chunk *chunk = create_or_get_chunk(&offset);
+	const world_xzpos xz_offset = offset.xz();
+	world_full_chunk *const full_chunk = create_or_get_full_chunk(&xz_offset);
+	if (is_changing) full_chunk->mark_changed(); // Invalidate any retained mesh of this full chunk
+
+	world_chunk *chunk = full_chunk->subchunks + offset.y;
 	const vector3i local_pos = chunk_vals::world_to_local(position);
 	return (*(chunk->blocks ? chunk->blocks : chunk->allocate_blocks()))[local_pos.x][local_pos.y][local_pos.z];
 }
@@ -96,7 +122,7 @@ void world_obj::world_chunk_generator::natural_set(
 	const world_pos *const position,
 	const block_properties::block_attributes *const block_properties
 ) {
-	block_id &target = create_block_ref(position);
+	block_id &target = create_block_ref(position, true);
 	target = (block_properties->strength >= block_properties::of_block(target)->strength) ?
 	          block_properties->mesh_info.id :
 	          target;
@@ -145,7 +171,7 @@ int_fast64_t world_obj::world_chunk_generator::noise_hash(const noise_object::bl
 void world_obj::world_chunk_generator::gen_full_chunk(const world_xzpos *const xz_offset) noexcept
 {
 	world_pos new_offset = { xz_offset->x, 0, xz_offset->y };
-	if (world->find_full_chunk_at(xz_offset) || get_chunk(&new_offset)) return;
+	if (world->find_full_chunk_at(xz_offset) || get_full_chunk(xz_offset)) return;
 
 	world_pos struct_world_pos = { new_offset.x * chunk_vals::size, 0, new_offset.z * chunk_vals::size };
 	const pos_t start_x = struct_world_pos.x, start_z = struct_world_pos.z;
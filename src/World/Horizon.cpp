@@ -0,0 +1,277 @@
+#include "Horizon.hpp"
+
+horizon_obj::horizon_obj(const noise_obj_list *noise_objs) noexcept : m_noise_objs(noise_objs)
+{
+	// Every tile uses the same triangles, offset to its slot with a base vertex
+	m_horizon_vao = ogl::new_vao();
+	glEnableVertexAttribArray(0);
+
+	GLushort tile_inds[tile_indices];
+	GLushort *current_ind = tile_inds;
+	for (int x = 0; x < tile_quads; ++x) {
+		for (int z = 0; z < tile_quads; ++z) {
+			const GLushort corner = static_cast<GLushort>((x * tile_side_verts) + z);
+			const GLushort quad_inds[6] = {
+				corner, static_cast<GLushort>(corner + 1), static_cast<GLushort>(corner + tile_side_verts),
+				static_cast<GLushort>(corner + tile_side_verts), static_cast<GLushort>(corner + 1), static_cast<GLushort>(corner + tile_side_verts + 1)
+			};
+			for (const GLushort ind : quad_inds) *current_ind++ = ind;
+		}
+	}
+
+	m_horizon_ebo = ogl::new_buf(GL_ELEMENT_ARRAY_BUFFER);
+	glBufferStorage(GL_ELEMENT_ARRAY_BUFFER, sizeof tile_inds, tile_inds, 0);
+
+	// Values that do not change are only set once
+	const shaders_obj::shader_prog &horizon_prog = game.shaders.programs.horizon;
+	horizon_prog.use();
+	horizon_prog.set_int("tv", tile_verts);
+	horizon_prog.set_int("ts", tile_side_verts);
+	horizon_prog.set_int("tb", tile_blocks);
+	horizon_prog.set_int("sb", sample_blocks);
+	horizon_prog.set_int("cb", chunk_vals::size_bits);
+	horizon_prog.set_flt("wy", static_cast<float>(chunk_vals::water_y));
+
+	if (!game.DB_exit_on_loaded) m_worker_thread = std::thread(&horizon_obj::worker_loop, this);
+}
+
+void horizon_obj::update_horizon(const world_xzpos *center, int32_t rnd_dist) noexcept
+{
+	upload_finished_tiles();
+	if (rnd_dist == m_rnd_dist && *center == m_center) return;
+
+	m_rnd_dist = rnd_dist;
+	m_center = *center;
+	m_horizon_dist = math::min(rnd_dist * horizon_dist_mult, max_horizon_dist);
+
+	// Enough tiles either side of the centre tile to contain every chunk within the horizon distance
+	const int32_t new_radius = (m_horizon_dist >> tile_chunks_bits) + 1;
+	if (new_radius != m_radius) resize_grid(new_radius);
+	m_center_tile = world_xzpos(m_center.x >> tile_chunks_bits, m_center.y >> tile_chunks_bits);
+
+	request_missing_tiles();
+}
+
+void horizon_obj::resize_grid(int32_t new_radius) noexcept
+{
+	m_radius = new_radius;
+	m_width = (new_radius * 2) + 1;
+	++m_epoch; // Tiles still being generated were placed using the previous width
+
+	const size_t slots_count = static_cast<size_t>(m_width * m_width);
+	m_slot_tiles.assign(slots_count, world_xzpos(math::lims<pos_t>::min(), math::lims<pos_t>::min()));
+	m_is_slot_ready.assign(slots_count, 0u);
+
+	// Recreate the vertex buffer with a range for each slot
+	glBindVertexArray(m_horizon_vao);
+	if (m_horizon_vbo) glDeleteBuffers(1, &m_horizon_vbo);
+	m_horizon_vbo = ogl::new_buf(GL_ARRAY_BUFFER);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+	glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(slots_count * sizeof(vertex_obj[tile_verts])), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+bool horizon_obj::is_tile_hidden(const world_xzpos &tile) const noexcept
+{
+	// Nearest and furthest chunk of the tile from the centre on each axis
+	const world_xzpos first = tile * tile_chunks, last = first + world_xzpos(tile_chunks - 1);
+	const pos_t near_x = math::clamp(m_center.x, first.x, last.x), near_z = math::clamp(m_center.y, first.y, last.y);
+	const pos_t far_x = math::max(math::abs(first.x - m_center.x), math::abs(last.x - m_center.x));
+	const pos_t far_z = math::max(math::abs(first.y - m_center.y), math::abs(last.y - m_center.y));
+
+	// Tiles entirely past the horizon or entirely covered by the rendered chunks (besides the last one, which fades out) are not needed
+	return math::abs(near_x - m_center.x) + math::abs(near_z - m_center.y) > m_horizon_dist || far_x + far_z < m_rnd_dist;
+}
+
+void horizon_obj::request_missing_tiles() noexcept
+{
+	std::vector<tile_request_obj> requests;
+	const world_xzpos low_tile = m_center_tile - world_xzpos(m_radius);
+
+	for (int32_t x = 0; x < m_width; ++x) {
+		for (int32_t z = 0; z < m_width; ++z) {
+			const world_xzpos tile = low_tile + world_xzpos(x, z);
+			if (is_tile_hidden(tile)) continue;
+
+			// Each tile has a fixed slot within the grid, regardless of where the centre is
+			const int32_t slot = static_cast<int32_t>(((((tile.x % m_width) + m_width) % m_width) * m_width) + (((tile.y % m_width) + m_width) % m_width));
+			const size_t slot_ind = static_cast<size_t>(slot);
+			if (m_slot_tiles[slot_ind] == tile && m_is_slot_ready[slot_ind]) continue;
+
+			m_slot_tiles[slot_ind] = tile;
+			m_is_slot_ready[slot_ind] = 0u;
+			requests.push_back({ tile, slot, m_epoch });
+		}
+	}
+
+	// Furthest tiles first as the worker takes requests from the back
+	const world_xzpos center_tile = m_center_tile;
+	std::sort(requests.begin(), requests.end(), [&center_tile](const tile_request_obj &a, const tile_request_obj &b) {
+		return chunk_vals::offsets_dist(&a.tile, &center_tile) > chunk_vals::offsets_dist(&b.tile, &center_tile);
+	});
+
+	// Replace the previous requests as they may no longer be in the grid
+	{
+		std::lock_guard<std::mutex> requests_guard(m_worker_mutex);
+		m_requests.swap(requests);
+	}
+	m_worker_conditional.notify_one();
+}
+
+void horizon_obj::upload_finished_tiles() noexcept
+{
+	std::vector<tile_result_obj> finished;
+	{
+		std::lock_guard<std::mutex> finished_guard(m_worker_mutex);
+		if (m_finished.empty()) return;
+		finished.swap(m_finished);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_horizon_vbo);
+	for (const tile_result_obj &result : finished) {
+		// Ignore tiles generated for a previous grid or for a slot that has since been given a different tile
+		const size_t slot_ind = static_cast<size_t>(result.request.slot);
+		if (result.request.epoch != m_epoch || m_slot_tiles[slot_ind] != result.request.tile) continue;
+
+		glBufferSubData(GL_ARRAY_BUFFER, static_cast<GLintptr>(slot_ind * sizeof result.verts), sizeof result.verts, result.verts);
+		m_is_slot_ready[slot_ind] = 1u;
+	}
+}
+
+float horizon_obj::surface_height_at(double block_x, double block_z) const noexcept
+{
+	// Same noise coordinates and scale as used when filling the noise table of a full chunk
+	constexpr double noise_block_mul = chunk_vals::noise_step / chunk_vals::size;
+	return (chunk_vals::surface_range * m_noise_objs->elevation.octave(
+		block_x * noise_block_mul, noise_def_vals::default_z_noise, block_z * noise_block_mul, 3
+	)) + chunk_vals::min_surface;
+}
+
+void horizon_obj::generate_tile(tile_result_obj *result) const noexcept
+{
+	// Heights include a border of samples from the neighbouring tiles to find the slope at the edges
+	constexpr int grid_side = tile_side_verts + 2;
+	float heights[grid_side * grid_side];
+
+	const world_xzpos start = (result->request.tile * tile_blocks) - world_xzpos(sample_blocks);
+	for (int i = 0; i < grid_side * grid_side; ++i) heights[i] = surface_height_at(
+		static_cast<double>(start.x + ((i / grid_side) * sample_blocks)),
+		static_cast<double>(start.y + ((i % grid_side) * sample_blocks))
+	);
+
+	constexpr float slope_mul = 1.0f / static_cast<float>(sample_blocks * 2);
+	vertex_obj *current_vert = result->verts;
+	for (int x = 1; x <= tile_side_verts; ++x) {
+		for (int z = 1; z <= tile_side_verts; ++z) {
+			const int ind = (x * grid_side) + z;
+			const float slope_x = (heights[ind + grid_side] - heights[ind - grid_side]) * slope_mul;
+			const float slope_z = (heights[ind + 1] - heights[ind - 1]) * slope_mul;
+
+			// Top of the surface block, shaded darker the steeper the surface is (Y of the surface normal)
+			current_vert->height = ::floorf(heights[ind]) + 1.0f;
+			current_vert->shade = 0.5f + (0.5f / ::sqrtf(1.0f + (slope_x * slope_x) + (slope_z * slope_z)));
+			++current_vert;
+		}
+	}
+}
+
+void horizon_obj::worker_loop() noexcept
+{
+	std::vector<tile_result_obj> results;
+	std::unique_lock<std::mutex> worker_lock(m_worker_mutex);
+
+	for (;;) {
+		m_worker_conditional.wait(worker_lock, [this]{ return !m_is_worker_active || !m_requests.empty(); });
+		if (!m_is_worker_active) return;
+
+		// Take the nearest requested tiles and generate them without holding the lock
+		results.resize(math::min(m_requests.size(), worker_batch));
+		for (tile_result_obj &result : results) {
+			result.request = m_requests.back();
+			m_requests.pop_back();
+		}
+
+		worker_lock.unlock();
+		thread_ops::split_ordered(worker_threads, results.size(), [&](int, size_t index) { generate_tile(&results[index]); });
+		worker_lock.lock();
+
+		m_finished.insert(m_finished.end(), results.begin(), results.end());
+	}
+}
+
+void horizon_obj::draw_horizon(const camera_frustum &frustum, const world_pos &render_base) noexcept
+{
+	if (m_radius < 0) return;
+
+	m_draw_base_verts.clear();
+	const vector3d &cam_pos = frustum.origin;
+	constexpr int batch_size = camera_frustum::box_batch_size;
+	constexpr float tile_flt = static_cast<float>(tile_blocks);
+	constexpr float min_y = static_cast<float>(chunk_vals::water_y), max_y = chunk_vals::max_terrain + 1.0f;
+
+	camera_frustum::box_batch_obj boxes;
+	camera_frustum::box_result_en results[batch_size];
+	float rotation_margins[batch_size];
+	int32_t batch_slots[batch_size];
+	int count = 0;
+
+	const auto test_batch = [&]() {
+		for (int i = count; i < batch_size; ++i) boxes.min_x[i] = boxes.min_y[i] = boxes.min_z[i] = boxes.max_x[i] = boxes.max_y[i] = boxes.max_z[i] = 0.0f;
+		frustum.test_box_batch(boxes, count, false, results, rotation_margins);
+		for (int i = 0; i < count; ++i) if (results[i] != camera_frustum::box_outside) m_draw_base_verts.push_back(batch_slots[i] * tile_verts);
+		count = 0;
+	};
+
+	// Draw the generated tiles that are (partly) past the render distance and inside the frustum
+	for (size_t slot_ind = 0; slot_ind < m_slot_tiles.size(); ++slot_ind) {
+		const world_xzpos &tile = m_slot_tiles[slot_ind];
+		if (!m_is_slot_ready[slot_ind] || is_tile_hidden(tile)) continue;
+
+		batch_slots[count] = static_cast<int32_t>(slot_ind);
+		boxes.min_x[count] = static_cast<float>(static_cast<double>(tile.x * tile_blocks) - cam_pos.x);
+		boxes.min_y[count] = static_cast<float>(static_cast<double>(min_y) - cam_pos.y);
+		boxes.min_z[count] = static_cast<float>(static_cast<double>(tile.y * tile_blocks) - cam_pos.z);
+		boxes.max_x[count] = boxes.min_x[count] + tile_flt;
+		boxes.max_y[count] = boxes.min_y[count] + (max_y - min_y);
+		boxes.max_z[count] = boxes.min_z[count] + tile_flt;
+		if (++count == batch_size) test_batch();
+	}
+	if (count) test_batch();
+	if (m_draw_base_verts.empty()) return;
+
+	const GLsizei draw_count = static_cast<GLsizei>(m_draw_base_verts.size());
+	m_draw_counts.assign(m_draw_base_verts.size(), tile_indices);
+	m_draw_indices.assign(m_draw_base_verts.size(), nullptr);
+
+	// Tiles are found from their slot and the position of the grid relative to the render base
+	const world_xzpos low_tile = m_center_tile - world_xzpos(m_radius);
+	shaders_obj::shader_prog &horizon_prog = game.shaders.programs.horizon;
+	horizon_prog.bind_and_use(m_horizon_vao);
+	horizon_prog.set_int("hw", m_width);
+	horizon_prog.set_int("hx", static_cast<GLint>(((low_tile.x % m_width) + m_width) % m_width));
+	horizon_prog.set_int("hz", static_cast<GLint>(((low_tile.y % m_width) + m_width) % m_width));
+	horizon_prog.set_int("bx", static_cast<GLint>(((low_tile.x * tile_chunks) - render_base.x) * chunk_vals::size));
+	horizon_prog.set_int("bz", static_cast<GLint>(((low_tile.y * tile_chunks) - render_base.z) * chunk_vals::size));
+	horizon_prog.set_int("gx", static_cast<GLint>(m_center.x - render_base.x));
+	horizon_prog.set_int("gz", static_cast<GLint>(m_center.y - render_base.z));
+	horizon_prog.set_int("rd", m_rnd_dist);
+
+	glMultiDrawElementsBaseVertex(
+		GL_TRIANGLES, m_draw_counts.data(), GL_UNSIGNED_SHORT,
+		m_draw_indices.data(), draw_count, m_draw_base_verts.data()
+	);
+}
+
+horizon_obj::~horizon_obj()
+{
+	// Stop the worker thread
+	{
+		std::lock_guard<std::mutex> worker_guard(m_worker_mutex);
+		m_is_worker_active = false;
+	}
+	m_worker_conditional.notify_all();
+	if (m_worker_thread.joinable()) m_worker_thread.join();
+
+	const GLuint delete_bufs[] = { m_horizon_vbo, m_horizon_ebo };
+	glDeleteBuffers(static_cast<GLsizei>(math::size(delete_bufs)), delete_bufs);
+	glDeleteVertexArrays(1, &m_horizon_vao);
+}
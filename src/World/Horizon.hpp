@@ -0,0 +1,69 @@
+#pragma once
+#ifndef SOURCE_WORLD_HORIZON_VXL_HDR
+#define SOURCE_WORLD_HORIZON_VXL_HDR
+
+#include "Application/Definitions.hpp"
+#include "World/Generation/Perlin.hpp"
+#include "Rendering/Frustum.hpp"
+
+// Coarse heightfield of the terrain past the render distance, sampled from the same elevation noise used
+// to generate chunks. Tiles are placed into slots by their position wrapped around the width of the grid,
+// so moving the centre only needs the ring of tiles that entered the grid to be generated (on a worker).
+class horizon_obj
+{
+public:
+	horizon_obj(const noise_obj_list *noise_objs) noexcept;
+
+	void update_horizon(const world_xzpos *center, int32_t rnd_dist) noexcept;
+	void draw_horizon(const camera_frustum &frustum, const world_pos &render_base) noexcept;
+	int32_t get_horizon_dist() const noexcept { return m_horizon_dist; }
+
+	static constexpr int32_t horizon_dist_mult = 4; // Horizon distance as a multiple of the render distance
+	static constexpr int32_t max_horizon_dist = 256; // Furthest distance (in chunks) within the far plane
+	static constexpr int tile_chunks_bits = 2;
+	static constexpr int32_t tile_chunks = 1 << tile_chunks_bits; // Full chunks along each side of a tile
+	static constexpr int tile_quads = 8; // Quads along each side of a tile
+	static constexpr int tile_blocks = tile_chunks * chunk_vals::size;
+	static constexpr int sample_blocks = tile_blocks / tile_quads; // Distance between height samples
+	static constexpr int tile_side_verts = tile_quads + 1, tile_verts = tile_side_verts * tile_side_verts;
+	static constexpr int tile_indices = tile_quads * tile_quads * 6;
+
+	~horizon_obj();
+private:
+	struct vertex_obj { float height, shade; };
+	struct tile_request_obj { world_xzpos tile; int32_t slot; uint32_t epoch; };
+	struct tile_result_obj { tile_request_obj request; vertex_obj verts[tile_verts]; };
+
+	const noise_obj_list *m_noise_objs;
+	GLuint m_horizon_vao = 0u, m_horizon_vbo = 0u, m_horizon_ebo = 0u;
+
+	int32_t m_rnd_dist = -1, m_horizon_dist = 0, m_radius = -1, m_width = 0;
+	world_xzpos m_center{}, m_center_tile{};
+	uint32_t m_epoch = 0u; // Results from before the grid was resized are dropped
+	std::vector<world_xzpos> m_slot_tiles; // Tile that each slot is assigned to
+	std::vector<uint8_t> m_is_slot_ready; // Slots that contain the data of their assigned tile
+
+	// Worker thread generating requested tiles, giving them back to the main thread to upload
+	static constexpr int worker_threads = 2;
+	static constexpr size_t worker_batch = 32; // Tiles taken from the requests at once
+	std::vector<tile_request_obj> m_requests; // Ordered furthest first so the nearest tiles are taken first
+	std::vector<tile_result_obj> m_finished;
+	std::mutex m_worker_mutex;
+	std::condition_variable m_worker_conditional;
+	std::thread m_worker_thread;
+	bool m_is_worker_active = true;
+
+	std::vector<GLint> m_draw_base_verts;
+	std::vector<GLsizei> m_draw_counts;
+	std::vector<const void*> m_draw_indices;
+
+	void worker_loop() noexcept;
+	void generate_tile(tile_result_obj *result) const noexcept;
+	void request_missing_tiles() noexcept;
+	void upload_finished_tiles() noexcept;
+	float surface_height_at(double block_x, double block_z) const noexcept;
+	void resize_grid(int32_t new_radius) noexcept;
+	bool is_tile_hidden(const world_xzpos &tile) const noexcept;
+};
+
+#endif // SOURCE_WORLD_HORIZON_VXL_HDR
@@ -4,7 +4,9 @@ world_obj::world_obj(world_acc_player *player) noexcept :
     world_noise_objs({1337, 1338, 1339, 1340, 1341}),
     world_plr(player)
 {
+	m_creation_time = glfwGetTime(); // Used to time how long the first terrain takes to appear
 	m_generator.world = this; // Set world pointer for nested generator struct
+	update_gen_center(); // Initial generation is around the player
 
 	// VAO and VBO for debug chunk borders
 	m_borders_vao = ogl::new_vao();
@@ -41,57 +43,107 @@ world_obj::world_obj(world_acc_player *player) noexcept :
 	glEnableVertexAttribArray(0);
 	glVertexAttribDivisor(0, 1);
 
-	glEnableVertexAttribArray(1);
-	glEnableVertexAttribArray(2);
-	glEnableVertexAttribArray(3);
-
-	// Very important definition of a plane/quad for block rendering
-	// Laid out like this to allow for swizzling (e.g. vector.xyz) which is "essentially free" in shaders
-	// See https://www.khronos.org/opengl/wiki/GLSL_Optimizations for more information
-
-	const float plane_verts[] = {
-	//              vec4 0                    vec4 1                    vec4 2
-		1.0f, 1.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 1.0f,   0.0f, 0.0f, 0.0f, 0.0f,  // Vertex 1
-		1.0f, 0.0f, 0.0f, 1.0f,   0.0f, 0.0f, 0.0f, 1.0f,   0.0f, 1.0f, 0.0f, 0.0f,  // Vertex 2
-		0.0f, 1.0f, 0.0f, 1.0f,   1.0f, 1.0f, 0.0f, 1.0f,   1.0f, 0.0f, 0.0f, 0.0f,  // Vertex 3
-		0.0f, 0.0f, 0.0f, 1.0f,   1.0f, 0.0f, 0.0f, 1.0f,   1.0f, 1.0f, 0.0f, 0.0f,  // Vertex 4
-	//        x     z     0     1       y     z     0     1       y     w     0     0
-	};
-
-	// Instanced VBO that contains plane data, 12 floats per vertex
-	m_world_plane_vbo = ogl::new_buf(GL_ARRAY_BUFFER);
-	glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(float[12]), nullptr);
-	glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(float[12]), reinterpret_cast<const void*>(sizeof(float[4])));
-	glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(float[12]), reinterpret_cast<const void*>(sizeof(float[8])));
-	glBufferStorage(GL_ARRAY_BUFFER, sizeof plane_verts, plane_verts, 0);
-
-	// World data buffer for instanced face data
+	// World data buffer for instanced face data, with chunks placed into ranges inside of it.
+	// Quad corners are created in the shader from the vertex ID and face index, so this is the only attribute.
 	m_world_inst_vbo = ogl::new_buf(GL_ARRAY_BUFFER);
 	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, 0, nullptr);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW); // Buffer to allow mapping (size 0 is invalid)
+	glBufferStorage(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(sizeof(quad_data_t) * initial_inst_capacity), nullptr, inst_buffer_flags);
+	m_inst_allocator.reset(initial_inst_capacity);
 
 	// Shader storage buffer object (SSBO) to store chunk positions and face indexes for each chunk face (location = 0)
-	m_world_ssbo = ogl::new_buf(GL_SHADER_STORAGE_BUFFER);
-	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_world_ssbo);
-	m_world_dib = ogl::new_buf(GL_DRAW_INDIRECT_BUFFER); // Buffer for indirect draw commands (4 GLuints per command)
-
-	update_render_distance(m_render_distance); // Initial update and buffer sizing
+	// and the buffer for indirect draw commands (4 GLuints per command), resized with the number of command slots
+	update_world_arrays(min_stream_capacity);
+	update_render_distance(m_render_distance); // Initial update
 
 	// Chunk creation loop on a separate thread to avoid blocking main game loop
 	if (!game.DB_exit_on_loaded) m_generation_thread = std::thread(&world_obj::generation_loop, this, false);
+	if (!game.DB_exit_on_loaded && game.upload_window_ptr) m_upload_thread = std::thread(&world_obj::upload_loop, this);
+
+	// Sorting workers for every other available thread, leaving the main thread to submit
+	if (!game.DB_exit_on_loaded) {
+		for (int i = 0; i < math::max(1, game.available_threads - 1); ++i) {
+			m_sort_threads.emplace_back(&world_obj::sort_worker_loop, this, static_cast<size_t>(i));
+		}
+	}
 }
 
 void world_obj::draw_entire_world() noexcept
 {
 	game.shaders.programs.blocks.bind_and_use(m_world_vao); // Use correct VAO and shader program
+	if (is_upload_pending()) apply_upload_batch(false); // Swap in new meshes if the upload thread has written them
 	if (m_do_buffers_update) update_inst_buffer_data(); // Update buffers if needed
+	// Use the results of a finished full sort, unless the shader was already given the base of the current region
+	if (m_is_sort_pending && m_render_base == m_region_render_base) sort_world_render();
+	if (!m_indirect_calls) goto fence_releases;
+
+	// The last chunk of the render distance fades into the distant terrain, measured from the generation center
+	game.shaders.programs.blocks.set_int("gx", static_cast<GLint>(m_gen_center.x - m_region_render_base.x));
+	game.shaders.programs.blocks.set_int("gz", static_cast<GLint>(m_gen_center.y - m_region_render_base.z));
+	game.shaders.programs.blocks.set_int("rd", m_render_distance);
+
+	// Use the region of the command and offset buffers that was last written to
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_world_dib);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_world_ssbo,
+		m_shader_offset_region_bytes * m_stream_region, m_shader_offset_region_bytes
+	);
 
 	// Draw the entire world in a single draw call using the indirect buffer, essentially
 	// doing an instanced draw call (glDrawArraysInstancedBaseInstance) for each 'chunk face'.
 	// See https://registry.khronos.org/OpenGL-Refpages/gl4/html/glMultiDrawArraysIndirect.xhtml for more information.
 
-	glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP, nullptr, m_indirect_calls, 0);
+	#if defined(VOXEL_DEBUG)
+	begin_overdraw_query();
+	#endif
+	glMultiDrawArraysIndirect(GL_TRIANGLE_STRIP,
+		reinterpret_cast<const void*>(m_indirect_region_bytes * m_stream_region), m_indirect_calls, 0
+	);
+	#if defined(VOXEL_DEBUG)
+	end_overdraw_query();
+	#endif
+
+	// The next sort needs to use a different region until the GPU is finished with this one
+	if (m_stream_fences[m_stream_region]) glDeleteSync(m_stream_fences[m_stream_region]);
+	m_stream_fences[m_stream_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	m_is_region_drawn = true;
+
+fence_releases:
+	// Ranges released before the slots of this region were assigned can be reused once the GPU has reached this point
+	if (!m_unfenced_releases.empty() && (!m_indirect_calls || static_cast<int32_t>(m_region_slots_serial - m_unfenced_slots_serial) > 0)) {
+		m_pending_releases.emplace_back(pending_release_obj{
+			glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), std::move(m_unfenced_releases)
+		});
+		m_unfenced_releases.clear();
+	}
+}
+
+#if defined(VOXEL_DEBUG)
+void world_obj::begin_overdraw_query() noexcept
+{
+	if (!m_overdraw_queries[0]) glGenQueries(overdraw_queries, m_overdraw_queries);
+
+	// Read the oldest query before it is reused, keeping the previous ratio if the GPU has not reached it yet
+	const GLuint query = m_overdraw_queries[m_overdraw_query];
+	if (m_is_query_pending[m_overdraw_query]) {
+		GLuint is_available = GL_FALSE;
+		glGetQueryObjectuiv(query, GL_QUERY_RESULT_AVAILABLE, &is_available);
+		if (is_available) {
+			GLuint64 samples_passed = 0u;
+			glGetQueryObjectui64v(query, GL_QUERY_RESULT, &samples_passed);
+			const double window_pixels = static_cast<double>(math::max(game.window_width * game.window_height, 1));
+			overdraw_ratio = static_cast<double>(samples_passed) / window_pixels;
+		}
+	}
+
+	glBeginQuery(GL_SAMPLES_PASSED, query);
+}
+
+void world_obj::end_overdraw_query() noexcept
+{
+	glEndQuery(GL_SAMPLES_PASSED);
+	m_is_query_pending[m_overdraw_query] = true;
+	m_overdraw_query = (m_overdraw_query + 1) % overdraw_queries;
 }
+#endif
 
 void world_obj::draw_enabled_borders() noexcept
 {
@@ -137,6 +189,7 @@ void world_obj::set_block_at_to(const world_pos *pos, block_id block) noexcept
 	}
 
 	(*(chunk->blocks))[in_pos.x][in_pos.y][in_pos.z] = block; // Change block at local position
+	full_chunk->mark_changed(); // Invalidate any retained mesh of this full chunk
 	quad_data_t *const mesh_data = update_chunk_immediate(full_chunk, chunk, &xz_offset, offset.y, nullptr);
 
 	// Update bordering chunks if changed block was on the chunk's corner
@@ -153,13 +206,15 @@ void world_obj::set_block_at_to(const world_pos *pos, block_id block) noexcept
 }
 
 quad_data_t *world_obj::update_chunk_immediate(
-	const world_full_chunk *const full_chunk,
+	world_full_chunk *const full_chunk,
 	world_chunk *const updating_chunk,
 	const world_xzpos *const xz_offset,
 	pos_t y_offset,
 	quad_data_t *mesh_data_array
 ) {
 	if (!mesh_data_array) mesh_data_array = new quad_data_t[chunk_vals::total_faces];
+	apply_upload_batch(true); // Face counts of chunks cannot change until their current meshes are written
+	discard_full_sort();
 
 	updating_chunk->mesh_faces(
 		rendered_map,
@@ -167,8 +222,14 @@ quad_data_t *world_obj::update_chunk_immediate(
 		xz_offset,
 		updating_chunk->face_counters,
 		y_offset,
-		mesh_data_array
+		mesh_data_array,
+		full_chunk->mesh_key.lod_key // Keep the same detail as the rest of the full chunk
 	);
+	updating_chunk->state |= world_chunk::states_en::needs_upload;
+	full_chunk->update_geometry_summary();
+
+	// Keep the mesh key current so the new mesh can still be retained when leaving render distance
+	if (full_chunk->has_been_meshed()) full_chunk->mesh_key = get_mesh_key(xz_offset, full_chunk, full_chunk->mesh_key.lod_key);
 	m_do_buffers_update = true;
 	return mesh_data_array;
 }
@@ -251,11 +312,66 @@ pos_t world_obj::highest_solid_y_at(world_xzpos *xz_position) const noexcept
 	return 0;
 }
 
-bool world_obj::xz_in_rnd_dist(const world_xzpos *chunk_offset) const noexcept
+bool world_obj::xz_in_rnd_dist(const world_xzpos *chunk_offset, int32_t extra_dist) const noexcept
+{
+	// Check if the XZ offset between the given and generation center are within the (extended) render distance
+	return chunk_vals::offsets_dist(chunk_offset, &m_gen_center) <= static_cast<pos_t>(m_render_distance + extra_dist);
+}
+
+void world_obj::update_gen_center() noexcept
+{
+	m_gen_center = world_plr->offset.xz();
+	{
+		std::lock_guard<std::mutex> target_guard(m_gen_target_mutex);
+		m_gen_target = { m_gen_center, m_render_distance };
+	}
+
+	// Camera direction without pitch, used to generate chunks in front of the player first
+	const vector3d &front = world_plr->frustum.near_pl.normal;
+	const vector2f view_xz = { static_cast<float>(front.x), static_cast<float>(front.z) };
+	const float view_length = view_xz.length();
+	m_gen_view_dir = view_length > 0.0f ? view_xz / view_length : vector2f{};
+}
+
+void world_obj::retarget_generation() noexcept
 {
-	// Check if the XZ offset between the given and player together are less than the render distance
+	// Set the new area the generation thread should work towards and drop work outside of it
+	const world_xzpos plr_xz_offset = world_plr->offset.xz();
+	{
+		std::lock_guard<std::mutex> target_guard(m_gen_target_mutex);
+		m_gen_target = { plr_xz_offset, m_render_distance };
+	}
+
+	// Show the terrain around the player first if there is none loaded there
+	if (chunk_vals::offsets_dist(&plr_xz_offset, &m_gen_center) > m_render_distance) m_do_spawn_fast_path = true;
+	++m_gen_epoch;
+	signal_generation_thread();
+}
+
+bool world_obj::is_outside_gen_target(const world_xzpos *offset, int32_t extra_dist, uint32_t cycle_epoch) noexcept
+{
+	// Only need to check the target area if it has changed since the current generation cycle started
+	if (m_gen_epoch.load(std::memory_order_relaxed) == cycle_epoch) return false;
+	std::lock_guard<std::mutex> target_guard(m_gen_target_mutex);
+	return chunk_vals::offsets_dist(offset, &m_gen_target.center) > static_cast<pos_t>(m_gen_target.rnd_dist + extra_dist);
+}
+
+void world_obj::player_offset_changed() noexcept
+{
+	// Restart the dwell timer so jittering across a chunk border does not move the generation center
+	m_offset_change_time = game.global_time;
+
+	// Update straight away if the player has gone past the unload band
 	const world_xzpos plr_xz_offset = world_plr->offset.xz();
-	return chunk_vals::offsets_dist(chunk_offset, &plr_xz_offset) <= static_cast<pos_t>(m_render_distance);
+	if (chunk_vals::offsets_dist(&plr_xz_offset, &m_gen_center) > m_unload_band) retarget_generation();
+}
+
+void world_obj::set_unload_band(int32_t new_band, double new_dwell_time) noexcept
+{
+	m_unload_band = new_band;
+	m_center_dwell_time = new_dwell_time;
+	signal_generation_thread(); // Unload any chunks that are now outside of the band
+	formatter::log(formatter::fmt("Unload band changed (%d chunks, %.2fs dwell)", new_band, m_center_dwell_time));
 }
 
 void world_obj::update_render_distance(int32_t new_rnd_dist) noexcept
@@ -274,11 +390,9 @@ void world_obj::update_render_distance(int32_t new_rnd_dist) noexcept
 
 	// Signal generation thread to run if it is waiting for an event
 	if (game.is_loop_active) {
-		signal_generation_thread();
+		retarget_generation();
 		formatter::log(formatter::fmt("Render distance changed (%d)", m_render_distance));
 	}
-
-	m_do_arrays_update = true; // Update indirect, translucent and ssbo arrays
 }
 
 void world_obj::generation_loop(bool ismain) noexcept
@@ -288,6 +402,9 @@ void world_obj::generation_loop(bool ismain) noexcept
 		world_xzpos full_offset;
 		world_full_chunk *full_chunk;
 		world_chunk::face_counts_obj meshed_counters[chunk_vals::y_count][6];
+		world_full_chunk::mesh_key_obj mesh_key;
+		uint32_t lod_key;
+		bool is_restored, is_new, is_dropped; // 'New' chunks are those that came from the reserved map
 	};
 
 	static std::vector<meshing_data> to_mesh;
@@ -298,17 +415,33 @@ void world_obj::generation_loop(bool ismain) noexcept
 	switch (m_gen_thread_state)
 	{
 	case gen_state_en::both_finish: // No work currently, main and generation finished
+		// Move the generation center once the player has stayed in a different chunk for long enough
+		if (!m_do_gen_update && game.do_generate_signal && game.global_time - m_offset_change_time >= m_center_dwell_time)
+			m_do_gen_update = world_plr->offset.xz() != m_gen_center;
 		if (m_do_gen_update) goto gen_update; // Start thread and set state to active if an update is requested
 		break;
 	case gen_state_en::await_confirm: // Commit given chunks from generation thread for meshing
-		// Remove chunks outside render distance from main map as well as their mesh data
+		// Ensure the instance buffer contains every finished mesh before retaining any from it
+		if (m_do_buffers_update) update_inst_buffer_data();
+		if (is_upload_pending()) break; // Check again once the meshes have been written
+		discard_full_sort(); // Sorting workers search the render map for reachable chunks
+
+		// Remove chunks outside render distance (and unload band) from main map as well as their mesh data
 		for (auto it = rendered_map.begin(); it != rendered_map.end();) {
-			if (xz_in_rnd_dist(&it->first)) { ++it; continue; }
+			if (xz_in_rnd_dist(&it->first, m_unload_band)) { ++it; continue; }
+			cache_full_mesh(&it->first, it->second); // Retain mesh data in case the chunk comes back unchanged
+
 			for (int y = 0; y < chunk_vals::y_count; ++y) {
 				world_chunk *const chunk = it->second->subchunks + y;
 				::memset(chunk->quads_ptr, 0, sizeof chunk->quads_ptr);
+				release_inst_range(&chunk->inst_range);
+				delete[] chunk->resident_quads;
+				chunk->resident_quads = nullptr;
+				chunk->resident_count = 0;
 				chunk->state = 0u;
 			}
+			release_inst_range(&it->second->inst_range);
+			it->second->is_layout_changed = false;
 
 			m_generator.reserved_map.insert(*it);
 			it = rendered_map.erase(it);
@@ -327,24 +460,42 @@ void world_obj::generation_loop(bool ismain) noexcept
 		m_do_buffers_update = true; // Update which chunks can be rendered
 		break;
 	case gen_state_en::gen_finished: // Generation thread finished
+		if (is_upload_pending()) break; // Face counts of chunks cannot change until their current meshes are written
+		discard_full_sort(); // Sorting workers read the face counts as well
 		// Remove 'meshing' state from affected chunks
 		for (auto &it : remove_mesh_state) it->full_chunk->full_state &= ~world_full_chunk::state_en::generation_mark;
 
 		// Copy thread face counters result into chunks to use new data
 		for (auto &it : to_mesh) {
+			// Chunks dropped by the generation thread keep any previous mesh, or go back to
+			// the reserved map if they never had one so they can be meshed in a later cycle
+			if (it.is_dropped) {
+				it.full_chunk->full_state &= ~world_full_chunk::state_en::generation_mark;
+				if (!it.is_new) continue;
+				const auto found = rendered_map.find(it.full_offset);
+				if (found != rendered_map.end() && found->second == it.full_chunk) rendered_map.erase(found);
+				m_generator.reserved_map.insert(std::make_pair(it.full_offset, it.full_chunk));
+				continue;
+			}
+
+			it.full_chunk->mesh_key = it.mesh_key;
 			for (int i = 0; i < chunk_vals::y_count; ++i) {
-				::memcpy(it.full_chunk->subchunks[i].face_counters, it.meshed_counters[i], sizeof *it.meshed_counters);
-				it.full_chunk->subchunks[i].state &= ~world_chunk::states_en::use_tmp_data;
+				world_chunk *const chunk = it.full_chunk->subchunks + i;
+				::memcpy(chunk->face_counters, it.meshed_counters[i], sizeof *it.meshed_counters);
+				chunk->state |= world_chunk::states_en::needs_upload;
 			}
+			it.full_chunk->update_geometry_summary();
 		}
 
 		to_mesh.clear();
 
 		remove_mesh_state.clear();
 		m_do_buffers_update = true; // Update world buffers on next draw
+		if (m_was_spawn_fast_path) m_do_gen_update = true; // Generate the rest of the render distance straight away
 		// Wait until the next 'generate' signal unless one was given whilst the thread was active
 		if (m_do_gen_update) {
 		gen_update:
+			update_gen_center(); // Generation thread uses the current player offset
 			m_gen_thread_state = gen_state_en::active;
 			m_gen_conditional.notify_one();
 			m_do_gen_update = false;
@@ -361,11 +512,17 @@ generation_thread_entry:
 	nearby_full_data_obj nb_full_data[4];
 
 do { // I'd prefer if I didn't have to indent the whole generation logic for this
-	const world_xzpos curr_plr_xz_offset = world_plr->offset.xz(); // Generator-local player offset
-	const int32_t curr_rnd_dist = m_render_distance; // Generator-local render distance
+	const world_xzpos curr_plr_xz_offset = m_gen_center; // Generator-local player offset
+	m_was_spawn_fast_path = m_do_spawn_fast_path.exchange(false);
+	const int32_t curr_rnd_dist = m_was_spawn_fast_path ? // Generator-local render distance
+		math::min(spawn_rnd_dist, m_render_distance) :
+		m_render_distance;
+	const vector2f curr_view_dir = m_gen_view_dir; // Generator-local view direction
+	const uint32_t curr_gen_epoch = m_gen_epoch; // Work outside of the target area is dropped if this changes
+	const int32_t curr_unload_band = m_unload_band; // Generator-local unload band
 
 	// Calculate all surrounding chunks as well as those further than the render distance to determine structure placement
-	m_generator.generate_surrounding(&curr_plr_xz_offset, curr_rnd_dist);
+	m_generator.generate_surrounding(&curr_plr_xz_offset, curr_rnd_dist, &curr_view_dir, curr_gen_epoch);
 	if (!game.is_active) return;
 
 	// Determine chunks that need deletion and add those that are going to become visible
@@ -373,12 +530,20 @@ do { // I'd prefer if I didn't have to indent the whole generation logic for thi
 	for (auto it = m_generator.reserved_map.begin(); it != m_generator.reserved_map.end();) {
 		const pos_t total_offset_dist = chunk_vals::offsets_dist(&it->first, &curr_plr_xz_offset);
 		if (total_offset_dist > curr_rnd_dist) {
-			const bool is_deleting = m_generator.can_del_full_chunk(it->second, &it->first, &curr_plr_xz_offset, curr_rnd_dist);
-			if (is_deleting) { delete it->second; it = m_generator.reserved_map.erase(it); } else ++it;
+			// Keep generated chunks in the unload band as well so they are not regenerated when coming back
+			const bool is_deleting = m_generator.can_del_full_chunk(
+				it->second, &it->first, &curr_plr_xz_offset, curr_rnd_dist + curr_unload_band
+			);
+			if (is_deleting) {
+				erase_cached_mesh(&it->first);
+				delete it->second;
+				it = m_generator.reserved_map.erase(it);
+			} else ++it;
 			continue;
 		}
 
-		to_mesh.emplace_back(meshing_data{ it->first, it->second, {} }); // Add current full chunk (in render distance) to meshing list
+		// Add current full chunk (in render distance) to meshing list
+		to_mesh.emplace_back(meshing_data{ it->first, it->second, {}, {}, get_lod_key(&it->first, &curr_plr_xz_offset), false, true, false });
 		it->second->full_state |= world_full_chunk::state_en::generation_mark; // Mark as being modified
 
 		// Do the same for those adjacent to the current full chunk (that hasnt been added already)
@@ -387,37 +552,77 @@ do { // I'd prefer if I didn't have to indent the whole generation logic for thi
 			if ((curr_nb->full_chunk->full_state & world_full_chunk::state_en::generation_mark) ||
 			    chunk_vals::offsets_dist(&it->first, &curr_nb->xz_offset) > curr_rnd_dist) continue;
 			curr_nb->full_chunk->full_state |= world_full_chunk::state_en::generation_mark;
-			to_mesh.emplace_back(meshing_data{ curr_nb->xz_offset, curr_nb->full_chunk, {} });
+			to_mesh.emplace_back(meshing_data{
+				curr_nb->xz_offset, curr_nb->full_chunk, {}, {}, get_lod_key(&curr_nb->xz_offset, &curr_plr_xz_offset), false, false, false
+			});
 		}
 
 		it = m_generator.reserved_map.erase(it);
 	}
 
+	// Mesh chunks again that should now use another level of detail (only changed by the main thread whilst waiting below)
+	for (const auto &it : rendered_map) {
+		world_full_chunk *const full_chunk = it.second;
+		if ((full_chunk->full_state & world_full_chunk::state_en::generation_mark) || !full_chunk->has_been_meshed() ||
+		    chunk_vals::offsets_dist(&it.first, &curr_plr_xz_offset) > curr_rnd_dist) continue;
+		const uint32_t lod_key = get_lod_key(&it.first, &curr_plr_xz_offset);
+		if (lod_key == full_chunk->mesh_key.lod_key) continue;
+		full_chunk->full_state |= world_full_chunk::state_en::generation_mark;
+		to_mesh.emplace_back(meshing_data{ it.first, full_chunk, {}, {}, lod_key, false, false, false });
+	}
+
+	// Mesh the nearest chunks first so they are not the ones dropped if the player moves away
+	std::sort(to_mesh.begin(), to_mesh.end(), [&](const meshing_data &a, const meshing_data &b) {
+		return chunk_vals::offsets_dist(&a.full_offset, &curr_plr_xz_offset) <
+		       chunk_vals::offsets_dist(&b.full_offset, &curr_plr_xz_offset);
+	});
+
 	// Wait for main thread to confirm the ability to mesh to avoid conflicts when editing
 	if (!gen_thread_conditional_wait(gen_state_en::await_confirm)) return;
 
-	// Mesh all affected chunks in parallel
+	// Mesh all affected chunks in parallel, each thread using its own section of the temporary quad data
 	meshing_data *const affected_ptr = to_mesh.data();
-	thread_ops::split(game.generation_thread_count, to_mesh.size(), [&](int, size_t index, size_t end) {
-		quad_data_t *const full_quad_data = new quad_data_t[chunk_vals::total_faces];
-		meshing_data *local_mesh_ptr = affected_ptr + index;
-		const meshing_data *const local_end_ptr = affected_ptr + end;
-	mesh_subchunks_loop:
+	quad_data_t *const full_quad_data = new quad_data_t[chunk_vals::total_faces * static_cast<size_t>(game.generation_thread_count)];
+	thread_ops::split_ordered(game.generation_thread_count, to_mesh.size(), [&](int thread_index, size_t index) {
+		meshing_data *const local_mesh_ptr = affected_ptr + index;
+		if (!game.is_active) return;
+
+		// Drop chunks that are no longer near the player if the target area has changed
+		if (is_outside_gen_target(&local_mesh_ptr->full_offset, curr_unload_band, curr_gen_epoch)) {
+			local_mesh_ptr->is_dropped = true;
+			return;
+		}
+
+		// Reuse a retained mesh instead if nothing affecting it has changed since
+		local_mesh_ptr->mesh_key = get_mesh_key(&local_mesh_ptr->full_offset, local_mesh_ptr->full_chunk, local_mesh_ptr->lod_key);
+		local_mesh_ptr->is_restored = restore_cached_mesh(
+			&local_mesh_ptr->full_offset,
+			local_mesh_ptr->full_chunk,
+			&local_mesh_ptr->mesh_key,
+			local_mesh_ptr->meshed_counters
+		);
+		if (local_mesh_ptr->is_restored) {
+			for (world_chunk &chunk : local_mesh_ptr->full_chunk->subchunks) chunk.update_visibility_info();
+			return;
+		}
+
+		quad_data_t *const thread_quad_data = full_quad_data + (chunk_vals::total_faces * static_cast<size_t>(thread_index));
 		for (pos_t y_offset = 0; y_offset < chunk_vals::y_count; ++y_offset) {
-			if (!game.is_active) goto immediate_end;
 			local_mesh_ptr->full_chunk->subchunks[y_offset].mesh_faces(
 				rendered_map,
 				local_mesh_ptr->full_chunk,
 				&local_mesh_ptr->full_offset,
 				local_mesh_ptr->meshed_counters[y_offset],
 				y_offset,
-				full_quad_data
+				thread_quad_data,
+				local_mesh_ptr->lod_key
 			);
 		}
-		if (++local_mesh_ptr != local_end_ptr) goto mesh_subchunks_loop;
-	immediate_end:
-		delete[] full_quad_data;
 	});
+	delete[] full_quad_data;
+
+	// Restored meshes now belong to their chunks
+	for (const meshing_data &meshed : to_mesh) if (meshed.is_restored) erase_cached_mesh(&meshed.full_offset);
 
 	gen_thread_conditional_wait(gen_state_en::gen_finished); // Wait for a game exit or a generation event
 } while (game.is_active); // End of 'do...while' loop 
@@ -434,205 +639,1138 @@ bool world_obj::gen_thread_conditional_wait(gen_state_en new_state)
 
 void world_obj::update_inst_buffer_data() noexcept
 {
+	if (is_upload_pending()) return; // Changes are staged again once the batch being written has been applied
 	game.perfs.buf_update.start_timer();
-	existing_quads_count = 0;
-	active_chunks.clear();
+	process_pending_releases(); // Reuse any ranges the GPU has finished with
 
-	// Determine total number of quads and which chunks are valid for rendering
+	// Stage any new mesh data into ranges of the instance buffer
 	for (const auto &it : rendered_map) {
-		const bool is_full_meshing = it.second->full_state & world_full_chunk::state_en::generation_mark;
-		for (pos_t y_offset = 0; y_offset < chunk_vals::y_count; ++y_offset) {
-			world_chunk *const chunk = it.second->subchunks + y_offset;
+		world_full_chunk *const full_chunk = it.second;
+		const bool is_full_meshing = full_chunk->full_state & world_full_chunk::state_en::generation_mark;
+
+		// Every resident mesh needs to be uploaded again after the layout changes
+		const bool is_relayout = full_chunk->is_layout_changed;
+		full_chunk->is_layout_changed = false;
+
+		// Only visit subchunks with geometry (or that still need their previous data released)
+		bool has_uploaded = false;
+		for (pos_t y_offset = full_chunk->geometry_start_y; y_offset < full_chunk->geometry_end_y; ++y_offset) {
+			world_chunk *const chunk = full_chunk->subchunks + y_offset;
 			if (!chunk->blocks) continue; // Ignore air chunks
-			
-			// Ignore chunks being meshed that do not have any previous data to use in the meantime
+
+			// Chunks being meshed keep using their previous data in the meantime, if they have any
+			bool is_stored = false;
 			if (is_full_meshing) {
 				if (!(chunk->state & world_chunk::states_en::has_data_before)) continue;
-				else chunk->state |= world_chunk::states_en::use_tmp_data;
+			} else if (chunk->state & world_chunk::states_en::needs_upload) {
+				store_resident_quads(chunk);
+				has_uploaded = is_stored = true;
 			}
+			if ((is_stored || is_relayout) && !m_is_column_layout) upload_chunk_mesh(chunk);
+		}
+		if (m_is_column_layout && (has_uploaded || is_relayout)) upload_column_mesh(full_chunk);
+		if (has_uploaded) full_chunk->update_geometry_summary(); // Subchunks without faces no longer need to be visited
+	}
+
+	m_do_buffers_update = false;
+
+	// Write the staged meshes on the upload thread, only swapping in the new commands once it has finished
+	if (m_upload_batch.has_writes() && m_upload_thread.joinable()) submit_upload_batch();
+	else {
+		write_upload_batch(); // No upload context, so the meshes are written on this thread
+		apply_staged_changes();
+	}
+
+	game.perfs.buf_update.end_timer();
+}
+
+void world_obj::rebuild_active_chunks() noexcept
+{
+	discard_full_sort(); // Sorting workers read the active chunks
+	existing_quads_count = 0;
+	active_chunks.clear();
 
-			// Accumulate counters from each chunk face
-			const size_t prev_existing_count = existing_quads_count;
-			for (int i = 0; i < 6; ++i) existing_quads_count += chunk->face_counters[i].total_faces();
-			if (prev_existing_count == existing_quads_count) continue; // No faces present, ignore this chunk
-			active_chunks.emplace_back(active_chunk_obj{ chunk, &it.first, y_offset }); // Add to active list
+	// Determine total number of quads and which chunks are valid for rendering
+	m_occluders.clear();
+	for (const auto &it : rendered_map) {
+		world_full_chunk *const full_chunk = it.second;
+		const bool is_full_meshing = full_chunk->full_state & world_full_chunk::state_en::generation_mark;
+
+		// Each run of fully opaque subchunks is one occluder (not known yet for chunks being meshed)
+		const unsigned opaque_fill_mask = is_full_meshing ? 0u : full_chunk->opaque_fill_mask;
+		for (pos_t y_offset = 0; y_offset < chunk_vals::y_count && opaque_fill_mask >> y_offset; ++y_offset) {
+			if (!(opaque_fill_mask & (1u << y_offset))) continue;
+			const pos_t run_start = y_offset;
+			while (opaque_fill_mask & (1u << (y_offset + 1))) ++y_offset;
+
+			const vector3d run_min = world_pos{ it.first.x, run_start, it.first.y } * chunk_vals::size;
+			m_occluders.emplace_back(occlusion_buffer_obj::box_obj{
+				run_min, run_min + vector3d(chunk_vals::size, (y_offset - run_start + 1) * chunk_vals::size, chunk_vals::size)
+			});
+		}
+
+		for (pos_t y_offset = full_chunk->geometry_start_y; y_offset < full_chunk->geometry_end_y; ++y_offset) {
+			world_chunk *const chunk = full_chunk->subchunks + y_offset;
+			if (!chunk->blocks) continue; // Ignore air chunks
+			if (is_full_meshing && !(chunk->state & world_chunk::states_en::has_data_before)) continue;
+
+			if (!chunk->resident_count) continue; // No faces present, ignore this chunk
+			existing_quads_count += chunk->resident_count;
+			active_chunks.emplace_back(active_chunk_obj{ // Add to active list
+				chunk, &it.first, y_offset, full_chunk->mesh_key.lod_key & world_full_chunk::lod_level_mask, {}, {}, 0.0f, false
+			});
 		}
 	}
 
-	// Bind world vertex array and instanced buffer and map instanced quad data buffer
-	glBindVertexArray(m_world_vao);
-	glBindBuffer(GL_ARRAY_BUFFER, m_world_inst_vbo);
-	const uint32_t *const curr_inst_buffer = static_cast<uint32_t*>(glMapBuffer(GL_ARRAY_BUFFER, GL_READ_ONLY));
+	if (!m_has_first_terrain && existing_quads_count) {
+		m_has_first_terrain = true;
+		formatter::log(formatter::fmt("Time to first terrain: %.3fms", (glfwGetTime() - m_creation_time) * 1000.0));
+	}
 
-	// Allocate the exact amount of data needed
-	// TODO: realloc
-	uint32_t *const new_data_ptr = new uint32_t[existing_quads_count];
-	uint32_t new_index = 0;
+	assign_command_slots();
+	sort_world_render(); // Update rendered chunks and faces
+}
 
-	// Add all quad data to the above pointer from each valid chunk or its previously stored data
-	for (auto &it : active_chunks) {
-		const bool use_temp = it.chunk->state & world_chunk::states_en::use_tmp_data;
-		for (int i = 0; i < 6; ++i) {
-			const uint32_t dir_faces = it.chunk->face_counters[i].total_faces();
-			const size_t dir_faces_bytes = sizeof(uint32_t) * dir_faces;
-			const uint32_t *const curr_quad_ptr = it.chunk->quads_ptr[i];
-			uint32_t *const quad_data_dst = new_data_ptr + new_index;
-			uint32_t *const saved_data_index = it.chunk->glob_data_inds + i;
-
-			if (!curr_quad_ptr || use_temp) { // No new data or being edited, use stored data from buffer
-				::memcpy(quad_data_dst, curr_inst_buffer + *saved_data_index, dir_faces_bytes);
-			} else { // New data available, use it instead and then clear
-				::memcpy(quad_data_dst, curr_quad_ptr, dir_faces_bytes);
-				delete[] curr_quad_ptr;
-				it.chunk->quads_ptr[i] = nullptr;
+void world_obj::store_resident_quads(world_chunk *chunk) noexcept
+{
+	// Previous data is no longer needed as the entire mesh is replaced
+	chunk->state = (chunk->state & ~world_chunk::states_en::needs_upload) | world_chunk::states_en::has_data_before;
+	delete[] chunk->resident_quads;
+	chunk->resident_quads = nullptr;
+	chunk->resident_count = 0;
+
+	uint32_t total_quads = 0;
+	for (const world_chunk::face_counts_obj &counters : chunk->face_counters) total_quads += counters.total_faces();
+	if (!total_quads) return;
+
+	// Combine each face direction one after another into the resident copy
+	chunk->resident_quads = new quad_data_t[total_quads];
+	chunk->resident_count = total_quads;
+	uint32_t face_start = 0;
+	for (int i = 0; i < 6; ++i) {
+		const uint32_t dir_faces = chunk->face_counters[i].total_faces();
+		if (chunk->quads_ptr[i]) ::memcpy(chunk->resident_quads + face_start, chunk->quads_ptr[i], sizeof(quad_data_t) * dir_faces);
+		delete[] chunk->quads_ptr[i];
+		chunk->quads_ptr[i] = nullptr;
+		face_start += dir_faces;
+	}
+}
+
+void world_obj::upload_chunk_mesh(world_chunk *chunk) noexcept
+{
+	stage_range_release(&chunk->inst_range); // Previous range is no longer needed as the entire mesh is replaced
+	if (!chunk->resident_count) return;
+	allocate_inst_range(chunk->resident_count, &chunk->inst_range);
+
+	// The resident copy already has the same layout, so it is written in one range
+	upload_batch_obj::inds_obj *const inds = stage_chunk_inds(chunk);
+	uint32_t face_start = chunk->inst_range.start;
+	for (int i = 0; i < 6; ++i) {
+		inds->data_inds[i] = face_start;
+		inds->translucent_inds[i] = face_start + chunk->face_counters[i].opaque_count;
+		face_start += chunk->face_counters[i].total_faces();
+	}
+
+	stage_quads_write(chunk->inst_range.start, chunk->resident_quads, chunk->resident_count);
+}
+
+void world_obj::upload_column_mesh(world_full_chunk *full_chunk) noexcept
+{
+	// The whole column is uploaded again whenever any of its subchunks change
+	stage_range_release(&full_chunk->inst_range);
+	uint32_t total_quads = 0;
+	for (const world_chunk &chunk : full_chunk->subchunks) total_quads += chunk.resident_count;
+	if (!total_quads) return;
+	allocate_inst_range(total_quads, &full_chunk->inst_range);
+
+	// Indices of every subchunk are staged first so the pointers stay valid
+	upload_batch_obj::inds_obj *subchunk_inds[chunk_vals::y_count];
+	const size_t inds_start = m_upload_batch.inds.size();
+	for (world_chunk &chunk : full_chunk->subchunks) stage_chunk_inds(&chunk);
+	for (int y = 0; y < chunk_vals::y_count; ++y) subchunk_inds[y] = m_upload_batch.inds.data() + inds_start + y;
+
+	// Opaque faces of every subchunk followed by the translucent faces of every subchunk, for each face direction
+	uint32_t column_ind = 0;
+	for (int i = 0; i < 6; ++i) {
+		for (int is_translucent = 0; is_translucent < 2; ++is_translucent) {
+			for (int y = 0; y < chunk_vals::y_count; ++y) {
+				if (!full_chunk->subchunks[y].resident_count) continue;
+				const world_chunk::face_counts_obj &counters = full_chunk->subchunks[y].face_counters[i];
+				(is_translucent ? subchunk_inds[y]->translucent_inds : subchunk_inds[y]->data_inds)[i] = full_chunk->inst_range.start + column_ind;
+				column_ind += is_translucent ? counters.translucent_count : counters.opaque_count;
 			}
+		}
+	}
+
+	// Only the sources are staged, the quads themselves are interleaved when the batch is written
+	m_upload_batch.column_writes.emplace_back();
+	upload_batch_obj::column_write_obj &column_write = m_upload_batch.column_writes.back();
+	column_write.offset = static_cast<GLintptr>(sizeof(quad_data_t) * full_chunk->inst_range.start);
+	column_write.count = total_quads;
+	for (int y = 0; y < chunk_vals::y_count; ++y) {
+		const world_chunk &chunk = full_chunk->subchunks[y];
+		column_write.sources[y] = chunk.resident_count ? chunk.resident_quads : nullptr;
+		::memcpy(column_write.counters[y], chunk.face_counters, sizeof column_write.counters[y]);
+	}
+}
+
+void world_obj::allocate_inst_range(uint32_t count, buffer_allocator_obj::range_obj *range) noexcept
+{
+	// Find space for the mesh, creating a larger buffer if no free range is large enough
+	if (m_inst_allocator.allocate(count, range)) return;
+	grow_inst_buffer(m_inst_allocator.get_capacity() + count);
+	m_inst_allocator.allocate(count, range);
+}
+
+void world_obj::stage_range_release(buffer_allocator_obj::range_obj *range) noexcept
+{
+	// Current commands still draw from the range until the batch replacing it is applied
+	if (!range->size) return;
+	m_upload_batch.releases.emplace_back(*range);
+	*range = {};
+}
+
+world_obj::upload_batch_obj::inds_obj *world_obj::stage_chunk_inds(world_chunk *chunk) noexcept
+{
+	m_upload_batch.inds.emplace_back(upload_batch_obj::inds_obj{ chunk, {}, {} });
+	return &m_upload_batch.inds.back();
+}
+
+void world_obj::stage_quads_write(uint32_t inst_start, const quad_data_t *quads, uint32_t count) noexcept
+{
+	m_upload_batch.writes.emplace_back(upload_batch_obj::write_obj{ static_cast<GLintptr>(sizeof(quad_data_t) * inst_start), quads, count });
+}
+
+void world_obj::submit_upload_batch() noexcept
+{
+	// The upload context waits for every command given so far (such as copying into a grown buffer) before writing
+	m_upload_batch.buffer = m_world_inst_vbo;
+	m_upload_batch.ready_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glFlush();
+
+	{
+		std::lock_guard<std::mutex> upload_guard(m_upload_mutex);
+		m_upload_state = upload_state_en::submitted;
+	}
+	m_upload_conditional.notify_all();
+}
+
+void world_obj::write_upload_batch() noexcept
+{
+	if (!m_upload_batch.has_writes()) return;
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_upload_batch.buffer ? m_upload_batch.buffer : m_world_inst_vbo);
+	for (const upload_batch_obj::write_obj &write : m_upload_batch.writes) {
+		glBufferSubData(GL_COPY_WRITE_BUFFER, write.offset, static_cast<GLsizeiptr>(sizeof(quad_data_t) * write.count), write.quads);
+	}
 
-			it.chunk->state |= world_chunk::states_en::has_data_before; // Mark as 'has been updated before'
-			*saved_data_index = new_index; // Set index for used data
-			new_index += dir_faces;
+	// Interleave the faces of each subchunk in a column in the same order their indices were staged in
+	for (const upload_batch_obj::column_write_obj &column : m_upload_batch.column_writes) {
+		m_upload_batch.column_quads.resize(column.count);
+		quad_data_t *const column_quads = m_upload_batch.column_quads.data();
+		uint32_t resident_starts[chunk_vals::y_count];
+		::memset(resident_starts, 0, sizeof resident_starts);
+
+		uint32_t column_ind = 0;
+		for (int i = 0; i < 6; ++i) {
+			for (int is_translucent = 0; is_translucent < 2; ++is_translucent) {
+				for (int y = 0; y < chunk_vals::y_count; ++y) {
+					if (!column.sources[y]) continue;
+					const world_chunk::face_counts_obj &counters = column.counters[y][i];
+					const uint32_t first = resident_starts[y] + (is_translucent ? counters.opaque_count : 0u);
+					const uint32_t count = is_translucent ? counters.translucent_count : counters.opaque_count;
+					if (count) ::memcpy(column_quads + column_ind, column.sources[y] + first, sizeof(quad_data_t) * count);
+					column_ind += count;
+				}
+			}
+			for (int y = 0; y < chunk_vals::y_count; ++y) resident_starts[y] += column.counters[y][i].total_faces();
 		}
+
+		glBufferSubData(GL_COPY_WRITE_BUFFER, column.offset, static_cast<GLsizeiptr>(sizeof(quad_data_t) * column.count), column_quads);
 	}
+}
 
-	// Unmap instanced quad data buffer then buffer in the new data
-	glUnmapBuffer(GL_ARRAY_BUFFER);
-	if (!existing_quads_count) glBufferData(GL_ARRAY_BUFFER, sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
-	else glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * existing_quads_count, new_data_ptr, GL_DYNAMIC_DRAW);
+void world_obj::upload_loop() noexcept
+{
+	glfwMakeContextCurrent(game.upload_window_ptr); // Context shares its objects with the game window
+	std::unique_lock<std::mutex> upload_lock(m_upload_mutex);
+
+	for (;;) {
+		m_upload_conditional.wait(upload_lock, [this]{ return !m_is_upload_active || m_upload_state == upload_state_en::submitted; });
+		if (!m_is_upload_active) break;
+		upload_lock.unlock();
+
+		glWaitSync(m_upload_batch.ready_fence, 0, GL_TIMEOUT_IGNORED);
+		write_upload_batch();
+		m_upload_batch.written_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		glFlush(); // Fence can only be reached once it has been sent to the GPU
+
+		upload_lock.lock();
+		m_upload_state = upload_state_en::written;
+		m_upload_conditional.notify_all();
+	}
 
-	delete[] new_data_ptr; // Delete created global quad array
-	m_do_buffers_update = false;
+	glfwMakeContextCurrent(nullptr);
+}
 
-	if (m_do_arrays_update) update_world_arrays(); // Update arrays if requested as well
-	sort_world_render(); // Update rendered chunks and faces
+bool world_obj::apply_upload_batch(bool do_wait) noexcept
+{
+	if (!is_upload_pending()) return true;
 
+	// Wait for the upload thread to finish giving the writes if needed
+	if (m_upload_state != upload_state_en::written) {
+		if (!do_wait) return false;
+		std::unique_lock<std::mutex> upload_lock(m_upload_mutex);
+		m_upload_conditional.wait(upload_lock, [this]{ return m_upload_state == upload_state_en::written; });
+	}
+
+	// The batch is normally written by the GPU before the next frame, so this should rarely need to wait
+	GLsync &written_fence = m_upload_batch.written_fence;
+	if (do_wait) while (glClientWaitSync(written_fence, 0, 1000000) == GL_TIMEOUT_EXPIRED);
+	else {
+		const GLenum wait_result = glClientWaitSync(written_fence, 0, 0);
+		if (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED) return false;
+	}
+
+	glDeleteSync(written_fence);
+	glDeleteSync(m_upload_batch.ready_fence);
+	written_fence = m_upload_batch.ready_fence = nullptr;
+
+	// Bind the instance buffer again so the writes from the other context are seen by this one
+	glBindVertexArray(m_world_vao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_world_inst_vbo);
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, 0, nullptr);
+
+	m_upload_state = upload_state_en::idle;
+	game.perfs.buf_update.start_timer();
+	apply_staged_changes();
 	game.perfs.buf_update.end_timer();
+	return true;
 }
 
-void world_obj::update_world_arrays() noexcept
+void world_obj::apply_staged_changes() noexcept
 {
-	// Total number of (sub)chunk faces (6 for each face of a cube)
-	const size_t total_chunk_faces = get_chunks_count(true) * 6;
+	// Chunks now use their new ranges, and the previous ones are released after the next draw with the new commands
+	for (const upload_batch_obj::inds_obj &inds : m_upload_batch.inds) {
+		::memcpy(inds.chunk->glob_data_inds, inds.data_inds, sizeof inds.data_inds);
+		::memcpy(inds.chunk->glob_translucent_inds, inds.translucent_inds, sizeof inds.translucent_inds);
+	}
+	m_unfenced_releases.insert(m_unfenced_releases.end(), m_upload_batch.releases.begin(), m_upload_batch.releases.end());
+	m_unfenced_slots_serial = m_slots_serial;
 
-	// Delete any existing arrays (not UB deleting nullptr initially)
-	// TODO: realloc
-	delete[] m_translucent_faces;
-	delete[] m_indirect_array;
-	delete[] m_shader_offset_array;
+	m_upload_batch.writes.clear();
+	m_upload_batch.column_writes.clear();
+	m_upload_batch.inds.clear();
+	m_upload_batch.releases.clear();
+	m_upload_batch.buffer = 0u;
 
-	m_translucent_faces = new translucent_render_data[total_chunk_faces]; // Create array for chunk sorting with new size
+	rebuild_active_chunks();
+}
 
-	// Need double size as transparency needs to be rendered separately
-	const size_t total_chunk_faces_w_trnsp = total_chunk_faces * 2;
-	m_indirect_array = new indirect_cmd[total_chunk_faces_w_trnsp]; // Array for indirect command data (4 GLuints)
-	m_shader_offset_array = new ssbo_offset_data[total_chunk_faces_w_trnsp]; // Array for offest SSBO data in shader
+void world_obj::set_column_layout(bool is_column_layout) noexcept
+{
+	if (is_column_layout == m_is_column_layout) return;
+	apply_upload_batch(true); // Ranges of a batch being written would be released below
+	m_is_column_layout = is_column_layout;
 
-	// Ensure correct buffers are updated
+	// Release every range of the previous layout, uploading the resident quads in the new one on the next update
+	for (const auto &it : rendered_map) {
+		world_full_chunk *const full_chunk = it.second;
+		release_inst_range(&full_chunk->inst_range);
+		for (world_chunk &chunk : full_chunk->subchunks) release_inst_range(&chunk.inst_range);
+		full_chunk->is_layout_changed = true;
+	}
+	m_do_buffers_update = true;
+	formatter::log(formatter::fmt("Using the %s layout", is_column_layout ? "column" : "subchunk"));
+}
+
+void world_obj::release_inst_range(buffer_allocator_obj::range_obj *range) noexcept
+{
+	if (!range->size) return;
+	m_unfenced_releases.emplace_back(*range); // Given back to the allocator after the next draw with new slots completes
+	m_unfenced_slots_serial = m_slots_serial;
+	*range = {};
+}
+
+void world_obj::process_pending_releases() noexcept
+{
+	// Fences are placed in order so stop at the first one the GPU has not reached yet
+	auto it = m_pending_releases.begin();
+	for (; it != m_pending_releases.end(); ++it) {
+		const GLenum wait_result = glClientWaitSync(it->fence, 0, 0);
+		if (wait_result != GL_ALREADY_SIGNALED && wait_result != GL_CONDITION_SATISFIED) break;
+		for (buffer_allocator_obj::range_obj &range : it->ranges) m_inst_allocator.release(&range);
+		glDeleteSync(it->fence);
+	}
+	m_pending_releases.erase(m_pending_releases.begin(), it);
+}
+
+void world_obj::grow_inst_buffer(uint32_t min_capacity) noexcept
+{
+	const uint32_t old_capacity = m_inst_allocator.get_capacity();
+	const uint32_t new_capacity = math::max(old_capacity * 2u, min_capacity);
+
+	// Buffer storage is immutable, so create a larger buffer and copy the existing data into it
+	const GLuint new_inst_vbo = ogl::new_buf(GL_COPY_WRITE_BUFFER);
+	glBufferStorage(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(sizeof(quad_data_t) * new_capacity), nullptr, inst_buffer_flags);
+	glBindBuffer(GL_COPY_READ_BUFFER, m_world_inst_vbo);
+	glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(sizeof(quad_data_t) * old_capacity));
+	glDeleteBuffers(1, &m_world_inst_vbo);
+	m_world_inst_vbo = new_inst_vbo;
+
+	// Use the new buffer for the instanced attribute
 	glBindVertexArray(m_world_vao);
-	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_world_dib);
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_world_ssbo);
+	glBindBuffer(GL_ARRAY_BUFFER, m_world_inst_vbo);
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, 0, nullptr);
 
-	// Storage for draw commands and SSBO data
-	glBufferData(GL_DRAW_INDIRECT_BUFFER, sizeof(indirect_cmd) * total_chunk_faces_w_trnsp, nullptr, GL_DYNAMIC_DRAW);
-	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ssbo_offset_data) * total_chunk_faces_w_trnsp, nullptr, GL_DYNAMIC_COPY);
+	m_inst_allocator.grow(new_capacity);
+	formatter::log(formatter::fmt("Instance buffer resized (%u quads)", new_capacity));
+}
 
-	m_do_arrays_update = false;
+void world_obj::reserve_stream_capacity(size_t commands_count) noexcept
+{
+	size_t new_capacity = m_stream_capacity;
+	if (commands_count > m_stream_capacity) {
+		new_capacity = math::max(math::max(commands_count, m_stream_capacity * 2u), min_stream_capacity);
+	} else if (m_stream_capacity > min_stream_capacity && commands_count * stream_shrink_factor < m_stream_capacity) {
+		new_capacity = math::max(commands_count * 2u, min_stream_capacity);
+		m_command_slots.shrink_to_fit();
+		m_offset_slots.shrink_to_fit();
+	}
+
+	if (new_capacity != m_stream_capacity) update_world_arrays(new_capacity);
+}
+
+void world_obj::update_world_arrays(size_t new_capacity) noexcept
+{
+	// Remove previous buffers and their fences (buffers are unmapped when deleted)
+	for (GLsync &fence : m_stream_fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	const GLuint old_buffers[] = { m_world_dib, m_world_ssbo };
+	glDeleteBuffers(static_cast<GLsizei>(math::size(old_buffers)), old_buffers);
+
+	// Each region of the SSBO needs to start at a multiple of the binding offset alignment
+	GLint ssbo_alignment;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssbo_alignment);
+	const size_t ssbo_bytes = sizeof(ssbo_offset_data) * new_capacity;
+	const size_t alignment = static_cast<size_t>(math::max(ssbo_alignment, 1));
+	m_shader_offset_region_bytes = static_cast<GLsizeiptr>(((ssbo_bytes + alignment - 1u) / alignment) * alignment);
+	m_indirect_region_bytes = static_cast<GLsizeiptr>(sizeof(indirect_cmd) * new_capacity);
+
+	// Storage for draw commands and SSBO data, mapped for the lifetime of the buffers
+	m_world_dib = ogl::new_buf(GL_DRAW_INDIRECT_BUFFER);
+	glBufferStorage(GL_DRAW_INDIRECT_BUFFER, m_indirect_region_bytes * stream_regions, nullptr, stream_map_flags);
+	m_indirect_mapped = static_cast<uint8_t*>(
+		glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, m_indirect_region_bytes * stream_regions, stream_map_flags)
+	);
+
+	m_world_ssbo = ogl::new_buf(GL_SHADER_STORAGE_BUFFER);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, m_shader_offset_region_bytes * stream_regions, nullptr, stream_map_flags);
+	m_shader_offset_mapped = static_cast<uint8_t*>(
+		glMapBufferRange(GL_SHADER_STORAGE_BUFFER, 0, m_shader_offset_region_bytes * stream_regions, stream_map_flags)
+	);
+
+	m_stream_capacity = new_capacity;
+	m_stream_region = 0;
+	m_is_region_drawn = m_is_region_written = false;
+	m_indirect_calls = 0; // Nothing can be drawn until the commands are written into the new buffers
+	m_do_full_sort = true;
+}
+
+void world_obj::wait_stream_region(int region) noexcept
+{
+	// The region was last drawn with a few frames ago, so this should normally not need to wait
+	GLsync &fence = m_stream_fences[region];
+	if (!fence) return;
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+	glDeleteSync(fence);
+	fence = nullptr;
+}
+
+void world_obj::assign_command_slots() noexcept
+{
+	discard_full_sort(); // Sorting workers set the instance counts of the command slots
+	// Active chunks of the same full chunk are next to each other as they are added in order of Y offset
+	m_active_columns.clear();
+	for (uint32_t chunk_ind = 0; chunk_ind < static_cast<uint32_t>(active_chunks.size()); ++chunk_ind) {
+		const active_chunk_obj &it = active_chunks[chunk_ind];
+		if (m_active_columns.empty() || active_chunks[m_active_columns.back().first_chunk].xz_offset != it.xz_offset) {
+			m_active_columns.emplace_back(active_column_obj{ chunk_ind, chunk_ind, it.y_offset, it.y_offset });
+		}
+		active_column_obj &column = m_active_columns.back();
+		column.end_chunk = chunk_ind + 1u;
+		column.max_y = it.y_offset;
+	}
+
+	// Order the active chunks (or entire columns in the column layout) by squared distance in chunks
+	// from the camera chunk using a counting sort
+	const world_pos &center = world_plr->offset;
+	const auto unit_distance = [&](uint32_t unit_ind) {
+		if (m_is_column_layout) {
+			const world_xzpos diff = *active_chunks[m_active_columns[unit_ind].first_chunk].xz_offset - center.xz();
+			return static_cast<uint32_t>((diff.x * diff.x) + (diff.y * diff.y));
+		}
+		const active_chunk_obj &it = active_chunks[unit_ind];
+		const world_pos diff = world_pos{ it.xz_offset->x, it.y_offset, it.xz_offset->y } - center;
+		return static_cast<uint32_t>((diff.x * diff.x) + (diff.y * diff.y) + (diff.z * diff.z));
+	};
+	const uint32_t units_count = static_cast<uint32_t>(m_is_column_layout ? m_active_columns.size() : active_chunks.size());
+	m_slot_order_center = center;
+
+	uint32_t max_distance = 0;
+	for (uint32_t unit_ind = 0; unit_ind < units_count; ++unit_ind) max_distance = math::max(max_distance, unit_distance(unit_ind));
+	m_distance_counts.assign(max_distance + 2u, 0u);
+	for (uint32_t unit_ind = 0; unit_ind < units_count; ++unit_ind) ++m_distance_counts[unit_distance(unit_ind) + 1u];
+	for (uint32_t i = 1; i < static_cast<uint32_t>(m_distance_counts.size()); ++i) m_distance_counts[i] += m_distance_counts[i - 1];
+
+	m_slot_order.resize(units_count);
+	for (uint32_t unit_ind = 0; unit_ind < units_count; ++unit_ind) m_slot_order[m_distance_counts[unit_distance(unit_ind)]++] = unit_ind;
+
+	// Slots of each face direction are given to every chunk in the unit in order of Y offset,
+	// so in the column layout the commands of visible subchunks next to each other can be merged
+	uint32_t slot = 0;
+	const auto assign_unit_slots = [&](uint32_t unit_ind, bool is_translucent) {
+		const uint32_t first_chunk = m_is_column_layout ? m_active_columns[unit_ind].first_chunk : unit_ind;
+		const uint32_t end_chunk = m_is_column_layout ? m_active_columns[unit_ind].end_chunk : unit_ind + 1u;
+		for (int face_ind = 0; face_ind < 6; ++face_ind) {
+			for (uint32_t chunk_ind = first_chunk; chunk_ind < end_chunk; ++chunk_ind) {
+				active_chunk_obj &it = active_chunks[chunk_ind];
+				const world_chunk::face_counts_obj &counters = it.chunk->face_counters[face_ind];
+				if (!(is_translucent ? counters.translucent_count : counters.opaque_count)) continue;
+				(is_translucent ? it.translucent_slots : it.opaque_slots)[face_ind] = slot++;
+			}
+		}
+	};
+
+	// Opaque faces are drawn before all translucent faces (front to back), so give them the first slots
+	for (const uint32_t unit_ind : m_slot_order) assign_unit_slots(unit_ind, false);
+	for (auto order_it = m_slot_order.rbegin(); order_it != m_slot_order.rend(); ++order_it) assign_unit_slots(*order_it, true);
+
+	m_command_slots.resize(slot);
+	m_offset_slots.resize(slot);
+	reserve_stream_capacity(slot);
+
+	// Fill in the values that do not depend on visibility
+	for (const active_chunk_obj &it : active_chunks) {
+		const world_pos rel_corner = (world_pos{ it.xz_offset->x, 0, it.xz_offset->y } - m_render_base) * chunk_vals::size;
+		for (uint32_t face_ind = 0; face_ind < 6; ++face_ind) {
+			const world_chunk::face_counts_obj *const face_counts = it.chunk->face_counters + face_ind;
+			const ssbo_offset_data offset_data = {
+				static_cast<int32_t>(rel_corner.x), static_cast<int32_t>(rel_corner.y), static_cast<int32_t>(rel_corner.z),
+				face_ind | (it.lod_level << ssbo_lod_shift)
+			};
+
+			if (face_counts->opaque_count) {
+				m_command_slots[it.opaque_slots[face_ind]] = { 4, 0, 0, it.chunk->glob_data_inds[face_ind] };
+				m_offset_slots[it.opaque_slots[face_ind]] = offset_data;
+			}
+			if (face_counts->translucent_count) {
+				m_command_slots[it.translucent_slots[face_ind]] = { 4, 0, 0, it.chunk->glob_translucent_inds[face_ind] };
+				m_offset_slots[it.translucent_slots[face_ind]] = offset_data;
+			}
+		}
+	}
+
+	++m_slots_serial;
+	m_do_full_sort = true; // Visibility of every chunk needs to be determined again
+}
+
+void world_obj::update_render_base() noexcept
+{
+	// Called before the UBO values are written for the frame, so the shader never uses a different base chunk
+	const world_pos &offset = world_plr->offset;
+	const bool is_base_close = math::abs(offset.x - m_render_base.x) <= render_base_dist &&
+	                           math::abs(offset.y - m_render_base.y) <= render_base_dist &&
+	                           math::abs(offset.z - m_render_base.z) <= render_base_dist;
+	if (is_upload_pending()) return; // Offsets in the current commands are relative to the current base
+	if (!is_base_close) m_render_base = offset;
+
+	// Slots are also ordered by distance from the camera chunk, so they need to be assigned again when it changes
+	if (!is_base_close || offset != m_slot_order_center) assign_command_slots();
 }
 
 void world_obj::sort_world_render() noexcept
 {
+	if (is_upload_pending()) return; // Sorted again once the new meshes are written
 	game.perfs.render_sort.start_timer();
 
-	// Offset value data
-	ssbo_offset_data curr_offset_data;
-	m_indirect_calls = 0;
+	if (!m_indirect_mapped) {
+		discard_full_sort();
+		m_indirect_calls = 0;
+		game.perfs.render_sort.end_timer();
+		return;
+	}
+
+	// The previous region keeps being drawn until a running full sort has finished
+	bool has_changed = false;
+	if (m_is_sort_pending) {
+		if (!finish_full_sort(false)) {
+			game.perfs.render_sort.end_timer();
+			return;
+		}
+		has_changed = true;
+	}
+
+	// Results can only be reused when the camera has rotated from the same position
+	const camera_frustum &frustum = world_plr->frustum;
+	if (!frustum.has_same_origin(m_sort_frustum) || frustum.rotation_since(m_sort_frustum) > static_cast<double>(max_patch_rotation)) {
+		m_do_full_sort = true;
+	}
+	if (!m_do_full_sort && patch_sort_render()) has_changed = true;
+	if (has_changed) write_stream_region(); // Otherwise the current region can still be drawn
+
+	// Workers set the instance counts of the command slots, so they are only started once the region is written
+	if (m_do_full_sort) start_full_sort();
+	// New stream buffers (after a resize) have nothing to draw, so wait for the sort instead of skipping frames
+	if (m_is_sort_pending && !m_is_region_written && finish_full_sort(true)) write_stream_region();
+	game.perfs.render_sort.end_timer();
+}
+
+void world_obj::write_stream_region() noexcept
+{
+	// Write into the next region if the current one has been used in a draw as the GPU could still be reading it
+	if (m_is_region_drawn) {
+		m_stream_region = (m_stream_region + 1) % stream_regions;
+		m_is_region_drawn = false;
+		wait_stream_region(m_stream_region);
+	}
+	m_indirect_array = reinterpret_cast<indirect_cmd*>(m_indirect_mapped + (m_indirect_region_bytes * m_stream_region));
+	m_shader_offset_array = reinterpret_cast<ssbo_offset_data*>(
+		m_shader_offset_mapped + (m_shader_offset_region_bytes * m_stream_region)
+	);
+
+	// Copy every command slot into the region (only written to, as mapped memory can be slow to read)
+	if (m_is_column_layout) m_indirect_calls = write_column_commands();
+	else {
+		m_indirect_calls = static_cast<GLsizei>(m_command_slots.size());
+		::memcpy(m_indirect_array, m_command_slots.data(), sizeof(indirect_cmd) * m_command_slots.size());
+		::memcpy(m_shader_offset_array, m_offset_slots.data(), sizeof(ssbo_offset_data) * m_offset_slots.size());
+	}
+
+	m_region_render_base = m_render_base;
+	m_region_slots_serial = m_slots_serial;
+	m_is_region_written = true;
+}
+
+GLsizei world_obj::write_column_commands() noexcept
+{
+	// Slots with instance data following on from the previous drawn slot of the same column and face direction
+	// are combined into one command, skipping hidden slots entirely. The command being combined is kept here
+	// until it is complete, as the mapped region should only be written to.
+	GLsizei calls = 0;
+	indirect_cmd pending_cmd{};
+	ssbo_offset_data pending_offset{};
+	for (size_t slot = 0; slot < m_command_slots.size(); ++slot) {
+		const indirect_cmd &cmd = m_command_slots[slot];
+		if (!cmd.inst_count) continue;
+
+		const ssbo_offset_data &offset_data = m_offset_slots[slot];
+		if (pending_cmd.inst_count && pending_cmd.base_inst + pending_cmd.inst_count == cmd.base_inst &&
+		    !::memcmp(&pending_offset, &offset_data, sizeof offset_data)) {
+			pending_cmd.inst_count += cmd.inst_count;
+			continue;
+		}
+
+		if (pending_cmd.inst_count) {
+			m_indirect_array[calls] = pending_cmd;
+			m_shader_offset_array[calls++] = pending_offset;
+		}
+		pending_cmd = cmd;
+		pending_offset = offset_data;
+	}
+
+	if (pending_cmd.inst_count) {
+		m_indirect_array[calls] = pending_cmd;
+		m_shader_offset_array[calls++] = pending_offset;
+	}
+	return calls;
+}
+
+void world_obj::start_full_sort() noexcept
+{
+	// The camera keeps moving whilst the workers run, so they use a copy of its frustum and chunk
+	m_sort_frustum = world_plr->frustum; // Rotation margins are relative to this frustum
+	m_sort_offset = world_plr->offset;
+	m_sort_reach_radius = m_render_distance + m_unload_band + 1; // Grid covering every chunk that could be loaded
+	m_do_full_sort = false;
+
+	// Every worker draws a part of the occluders, except for the one searching for reachable chunks if there are others
+	const size_t workers_count = math::max(m_sort_threads.size(), static_cast<size_t>(1u));
+	m_occlusion_parts = static_cast<int>(workers_count > 1u ? workers_count - 1u : 1u);
+	m_occlusion.begin(m_sort_frustum, m_occlusion_parts);
+
+	// Use more workers only when there are enough columns for it to be worth it
+	const size_t partitions = math::max(static_cast<size_t>(1u), math::min(
+		m_sort_threads.size(),
+		m_active_columns.size() / sort_columns_per_thread
+	));
+	if (m_sort_slices.size() < partitions) m_sort_slices.resize(partitions);
+	m_is_sort_pending = true;
+
+	if (m_sort_threads.empty()) { // No workers, so sort on this thread instead
+		prepare_sort_part(0u);
+		sort_columns_slice(&m_sort_slices[0], 0u, m_active_columns.size());
+		m_sort_partitions = m_sort_finished = 1u;
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> sort_guard(m_sort_mutex);
+		m_sort_partitions = partitions;
+		m_sort_finished = m_sort_prepared = 0u;
+		m_is_sort_prepared = false;
+		++m_sort_serial;
+	}
+	m_sort_conditional.notify_all();
+}
+
+bool world_obj::finish_full_sort(bool do_wait) noexcept
+{
+	{
+		std::unique_lock<std::mutex> sort_lock(m_sort_mutex);
+		if (!do_wait && m_sort_finished != m_sort_partitions) return false;
+		m_sort_conditional.wait(sort_lock, [this]{ return m_sort_finished == m_sort_partitions; });
+	}
+	m_is_sort_pending = false;
 
-	// Counter variables
-	size_t translucent_count = 0;
 	rendered_squares_count = 0;
 	rendered_chunks_count = 0;
+	occluded_chunks_count = 0;
+	m_boundary_chunks.clear();
+
+	for (size_t i = 0; i < m_sort_partitions; ++i) {
+		const sort_slice_obj &slice = m_sort_slices[i];
+		m_boundary_chunks.insert(m_boundary_chunks.end(), slice.boundary_chunks.begin(), slice.boundary_chunks.end());
+		rendered_squares_count += slice.squares_count;
+		rendered_chunks_count += slice.chunks_count;
+		occluded_chunks_count += slice.occluded_count;
+	}
+	return true;
+}
 
-	// After storing the normal face data for every chunk, loop through the individual chunk faces
-	// that have translucent faces, giving the offset and chunk data for each
-	for (const auto &it : active_chunks) {
-		const world_pos curr_offset = { it.xz_offset->x, it.y_offset, it.xz_offset->y };
-		// Use frustum culling to determine if the chunk is on-screen
-		const vector3d corner = curr_offset * chunk_vals::size; // Get chunk corner
-		if (!world_plr->frustum.is_chunk_visible(corner)) continue;
-		++rendered_chunks_count;
-		
-		// Set offset data for shader
-		curr_offset_data.wrld_x = corner.x;
-		curr_offset_data.wrld_z = corner.z;
-		curr_offset_data.wrld_y = static_cast<float>(corner.y);
-		
-		for (curr_offset_data.face_ind = 0; curr_offset_data.face_ind < 6; ++curr_offset_data.face_ind) {
-			const world_chunk::face_counts_obj *const face_counts = it.chunk->face_counters + curr_offset_data.face_ind;
-			
-			// Add transparent part of face at the end if any
-			if (face_counts->translucent_count) m_translucent_faces[translucent_count++] = { curr_offset_data, it.chunk };
-			if (!face_counts->opaque_count) continue; // Ignore if there are no normal faces
-
-			// Check if it would even be possible to see this (opaque) face of the chunk
-			// e.g. you can't see (relatively) forward faces in a chunk in front of you
-			
-			switch (curr_offset_data.face_ind) {
-			case wdir_right:
-				if (world_plr->offset.x < curr_offset.x) continue;
-				break;
-			case wdir_left:
-				if (world_plr->offset.x > curr_offset.x) continue;
-				break;
-			case wdir_up:
-				if (world_plr->offset.y < curr_offset.y) continue;
-				break;
-			case wdir_down:
-				if (world_plr->offset.y > curr_offset.y) continue;
-				break;
-			case wdir_front:
-				if (world_plr->offset.z < curr_offset.z) continue;
-				break;
-			case wdir_back:
-				if (world_plr->offset.z > curr_offset.z) continue;
-				break;
-			default:
-				break;
+void world_obj::discard_full_sort() noexcept
+{
+	// Wait for a running sort before changing anything it reads, sorting again afterwards
+	if (!m_is_sort_pending) return;
+	finish_full_sort(true);
+	m_do_full_sort = true;
+}
+
+void world_obj::sort_worker_loop(size_t worker_ind) noexcept
+{
+	uint32_t sort_serial = 0u;
+	std::unique_lock<std::mutex> sort_lock(m_sort_mutex);
+
+	for (;;) {
+		m_sort_conditional.wait(sort_lock, [&]{ return !m_is_sort_active || m_sort_serial != sort_serial; });
+		if (!m_is_sort_active) break;
+		sort_serial = m_sort_serial;
+
+		sort_lock.unlock();
+		prepare_sort_part(worker_ind);
+		sort_lock.lock();
+
+		// Chunks are only tested once every part of the occluders is drawn and merged, by the last worker to finish
+		if (++m_sort_prepared == m_sort_threads.size()) {
+			m_occlusion.merge_parts();
+			m_is_sort_prepared = true;
+			m_sort_conditional.notify_all();
+		} else m_sort_conditional.wait(sort_lock, [&]{ return !m_is_sort_active || m_is_sort_prepared || m_sort_serial != sort_serial; });
+		if (!m_is_sort_active) break;
+		// Workers without a partition can miss the merge entirely if the next sort was already started
+		if (m_sort_serial != sort_serial || worker_ind >= m_sort_partitions) continue; // Not enough columns to need this worker
+
+		// Each worker determines the visibility of its own range of the active columns, setting
+		// the instance counts of their command slots, so workers never write to the same slot
+		const size_t columns_count = m_active_columns.size(), partitions = m_sort_partitions;
+		sort_lock.unlock();
+		sort_columns_slice(&m_sort_slices[worker_ind],
+			(columns_count * worker_ind) / partitions, (columns_count * (worker_ind + 1u)) / partitions
+		);
+
+		sort_lock.lock();
+		if (++m_sort_finished == m_sort_partitions) m_sort_conditional.notify_all();
+	}
+}
+
+void world_obj::prepare_sort_part(size_t worker_ind) noexcept
+{
+	// The last worker searches for reachable chunks (also drawing the only part of the occluders if it is alone)
+	if (worker_ind < static_cast<size_t>(m_occlusion_parts)) m_occlusion.rasterize_part(m_occluders, static_cast<int>(worker_ind));
+	if (worker_ind + 1u == math::max(m_sort_threads.size(), static_cast<size_t>(1u))) update_reachable_chunks();
+}
+
+bool world_obj::patch_sort_render() noexcept
+{
+	// Only chunks that were near a plane in the last full sort could have changed visibility
+	const camera_frustum &frustum = world_plr->frustum;
+	const float rotation = static_cast<float>(frustum.rotation_since(m_sort_frustum));
+	bool has_changed = false;
+
+	for (const uint32_t chunk_ind : m_boundary_chunks) {
+		active_chunk_obj &it = active_chunks[chunk_ind];
+		if (it.rotation_margin > rotation) continue;
+
+		const vector3d corner = world_pos{ it.xz_offset->x, it.y_offset, it.xz_offset->y } * chunk_vals::size;
+		const bool is_visible = frustum.is_chunk_visible(corner);
+		if (is_visible == it.is_visible) continue;
+
+		it.is_visible = is_visible;
+		const size_t chunk_squares = set_chunk_commands(it);
+		if (is_visible) {
+			rendered_squares_count += chunk_squares;
+			++rendered_chunks_count;
+		} else {
+			rendered_squares_count -= chunk_squares;
+			--rendered_chunks_count;
+		}
+		has_changed = true;
+	}
+
+	return has_changed;
+}
+
+void world_obj::sort_columns_slice(sort_slice_obj *slice, size_t index, size_t end) noexcept
+{
+	// Clear previous results but keep the allocated memory
+	slice->boundary_chunks.clear();
+	slice->partial_chunks.clear();
+	slice->squares_count = 0;
+	slice->chunks_count = 0;
+	slice->occluded_count = 0;
+
+	const camera_frustum &frustum = m_sort_frustum;
+	const vector3d &cam_pos = frustum.origin;
+	constexpr float size_flt = static_cast<float>(chunk_vals::size);
+	constexpr int batch_size = camera_frustum::box_batch_size;
+
+	camera_frustum::box_batch_obj boxes;
+	camera_frustum::box_result_en results[batch_size];
+	float rotation_margins[batch_size];
+
+	// Test whole columns first - every subchunk of a column that is outside or entirely inside
+	// has the same result, so only the subchunks of columns crossing a plane are tested individually
+	for (; index < end; index += batch_size) {
+		const int count = static_cast<int>(math::min(end - index, static_cast<size_t>(batch_size)));
+		for (int i = 0; i < count; ++i) {
+			const active_column_obj &column = m_active_columns[index + static_cast<size_t>(i)];
+			const world_xzpos *const xz_offset = active_chunks[column.first_chunk].xz_offset;
+			boxes.min_x[i] = static_cast<float>(static_cast<double>(xz_offset->x * chunk_vals::size) - cam_pos.x);
+			boxes.min_y[i] = static_cast<float>(static_cast<double>(column.min_y * chunk_vals::size) - cam_pos.y);
+			boxes.min_z[i] = static_cast<float>(static_cast<double>(xz_offset->y * chunk_vals::size) - cam_pos.z);
+			boxes.max_x[i] = boxes.min_x[i] + size_flt;
+			boxes.max_y[i] = boxes.min_y[i] + size_flt * static_cast<float>(column.max_y - column.min_y + 1);
+			boxes.max_z[i] = boxes.min_z[i] + size_flt;
+		}
+		for (int i = count; i < batch_size; ++i) boxes.min_x[i] = boxes.min_y[i] = boxes.min_z[i] = boxes.max_x[i] = boxes.max_y[i] = boxes.max_z[i] = 0.0f;
+
+		frustum.test_box_batch(boxes, count, true, results, rotation_margins);
+
+		for (int i = 0; i < count; ++i) {
+			// Subchunks of columns that are only just outside are tested individually as well
+			if (results[i] == camera_frustum::box_outside && rotation_margins[i] <= pending_sort_rotation) {
+				results[i] = camera_frustum::box_intersecting;
 			}
+			const active_column_obj &column = m_active_columns[index + static_cast<size_t>(i)];
+			const world_xzpos *const xz_offset = active_chunks[column.first_chunk].xz_offset;
+			const vector3d column_min = world_pos{ xz_offset->x, column.min_y, xz_offset->y } * chunk_vals::size;
+			const vector3d column_max = column_min + vector3d(
+				chunk_vals::size, (column.max_y - column.min_y + 1) * chunk_vals::size, chunk_vals::size
+			);
+			const bool is_column_occluded = results[i] != camera_frustum::box_outside && m_occlusion.is_box_occluded(column_min, column_max);
 
-			// Set indirect and offset data at the same indexes in both buffers
-			m_indirect_array[m_indirect_calls] = {
-				4, face_counts->opaque_count, 0,
-				it.chunk->glob_data_inds[curr_offset_data.face_ind]
-			};
-			m_shader_offset_array[m_indirect_calls++] = curr_offset_data; // Advance to next indirect call
-			rendered_squares_count += face_counts->opaque_count;
+			for (uint32_t chunk_ind = column.first_chunk; chunk_ind < column.end_chunk; ++chunk_ind) {
+				if (is_column_occluded || (results[i] == camera_frustum::box_inside && is_chunk_occluded(chunk_ind))) {
+					hide_occluded_chunk(slice, chunk_ind);
+				} else if (results[i] == camera_frustum::box_intersecting) slice->partial_chunks.emplace_back(chunk_ind);
+				else set_chunk_visibility(slice, chunk_ind, results[i] == camera_frustum::box_inside, rotation_margins[i]);
+			}
 		}
 	}
 
-	// Loop through all of the sorted chunk faces with translucent faces and save the specific data
-	for (size_t i = 0; i < translucent_count; ++i) {
-		// Get chunk face data
-		const translucent_render_data *const translucent_ptr = m_translucent_faces + i;
-		const uint32_t face_ind = translucent_ptr->ssbo_data.face_ind;
-		const world_chunk::face_counts_obj *const face_counters = translucent_ptr->chunk->face_counters + face_ind;
+	// Test the subchunks of columns that cross a plane
+	const std::vector<uint32_t> &partial_chunks = slice->partial_chunks;
+	for (size_t partial_ind = 0; partial_ind < partial_chunks.size(); partial_ind += batch_size) {
+		const int count = static_cast<int>(math::min(partial_chunks.size() - partial_ind, static_cast<size_t>(batch_size)));
+		for (int i = 0; i < count; ++i) {
+			const active_chunk_obj &it = active_chunks[partial_chunks[partial_ind + static_cast<size_t>(i)]];
+			boxes.min_x[i] = static_cast<float>(static_cast<double>(it.xz_offset->x * chunk_vals::size) - cam_pos.x);
+			boxes.min_y[i] = static_cast<float>(static_cast<double>(it.y_offset * chunk_vals::size) - cam_pos.y);
+			boxes.min_z[i] = static_cast<float>(static_cast<double>(it.xz_offset->y * chunk_vals::size) - cam_pos.z);
+			boxes.max_x[i] = boxes.min_x[i] + size_flt;
+			boxes.max_y[i] = boxes.min_y[i] + size_flt;
+			boxes.max_z[i] = boxes.min_z[i] + size_flt;
+		}
+		for (int i = count; i < batch_size; ++i) boxes.min_x[i] = boxes.min_y[i] = boxes.min_z[i] = boxes.max_x[i] = boxes.max_y[i] = boxes.max_z[i] = 0.0f;
+
+		frustum.test_box_batch(boxes, count, false, results, rotation_margins);
 
-		// Same as above but with translucent data
-		m_indirect_array[m_indirect_calls] = {
-			4, face_counters->translucent_count,
-			0, translucent_ptr->chunk->glob_data_inds[face_ind] + face_counters->opaque_count,
-		};
-		m_shader_offset_array[m_indirect_calls++] = translucent_ptr->ssbo_data;
-		rendered_squares_count += face_counters->translucent_count;
+		for (int i = 0; i < count; ++i) {
+			const uint32_t chunk_ind = partial_chunks[partial_ind + static_cast<size_t>(i)];
+			const bool is_visible = results[i] != camera_frustum::box_outside || rotation_margins[i] <= pending_sort_rotation;
+			if (is_visible && is_chunk_occluded(chunk_ind)) hide_occluded_chunk(slice, chunk_ind);
+			else set_chunk_visibility(slice, chunk_ind, is_visible, rotation_margins[i]);
+		}
 	}
+}
 
-	// Bind buffers to edit
-	glBindVertexArray(m_world_vao); 
-	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_world_ssbo);
-	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_world_dib);
-	
-	// Update SSBO and indirect buffer with their respective data and sizes
-	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, sizeof(indirect_cmd) * m_indirect_calls, m_indirect_array);
-	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(ssbo_offset_data) * m_indirect_calls, m_shader_offset_array);
+bool world_obj::is_chunk_occluded(uint32_t chunk_ind) const noexcept
+{
+	const active_chunk_obj &it = active_chunks[chunk_ind];
+	const world_pos offset = { it.xz_offset->x, it.y_offset, it.xz_offset->y };
 
-	game.perfs.render_sort.end_timer();
+	// Chunks that cannot be seen through any opening count as occluded as well
+	if (m_is_reach_culling) {
+		const int32_t grid_index = reachable_index(&offset);
+		if (grid_index != -1 && m_reachable[static_cast<size_t>(grid_index)] != m_reach_stamp) return true;
+	}
+
+	const vector3d corner = offset * chunk_vals::size;
+	return m_occlusion.is_box_occluded(corner, corner + vector3d(chunk_vals::size));
+}
+
+int32_t world_obj::reachable_index(const world_pos *offset) const noexcept
+{
+	// -1 if the offset is outside of the searched grid
+	const pos_t grid_x = offset->x - m_reachable_origin.x, grid_z = offset->z - m_reachable_origin.z;
+	if (grid_x < 0 || grid_z < 0 || grid_x >= m_reachable_width || grid_z >= m_reachable_width) return -1;
+	if (offset->y < 0 || offset->y >= chunk_vals::y_count) return -1;
+	return static_cast<int32_t>(((grid_x * m_reachable_width) + grid_z) * chunk_vals::y_count + offset->y);
+}
+
+void world_obj::update_reachable_chunks() noexcept
+{
+	m_is_reach_culling = false;
+
+	// Only search from inside the world, otherwise rely on the other culling methods
+	const world_pos start = m_sort_offset;
+	if (start.y < 0 || start.y >= chunk_vals::y_count) return;
+	const world_xzpos start_xz = { start.x, start.z };
+	const world_full_chunk *const start_full_chunk = find_full_chunk_at(&start_xz);
+	if (!start_full_chunk) return;
+
+	const int32_t grid_radius = m_sort_reach_radius;
+	m_reachable_width = (grid_radius * 2) + 1;
+	m_reachable_origin = { start.x - grid_radius, 0, start.z - grid_radius };
+
+	// Only clear the grid when it is resized or the stamp wraps around
+	const size_t columns_count = static_cast<size_t>(m_reachable_width * m_reachable_width);
+	if (m_reach_columns.size() != columns_count || !++m_reach_stamp) {
+		m_reachable.assign(columns_count * chunk_vals::y_count, 0u);
+		m_reach_columns.assign(columns_count, reach_column_obj{ nullptr, 0u });
+		m_reach_stamp = 1u;
+	}
+
+	// The camera chunk can be seen out of in any direction
+	m_reach_queue.clear();
+	m_reach_queue.emplace_back(reach_search_obj{ start, world_chunk::all_face_connections, -1, 0u });
+	m_reachable[static_cast<size_t>(reachable_index(&start))] = m_reach_stamp;
+
+	for (size_t queue_ind = 0; queue_ind < m_reach_queue.size(); ++queue_ind) {
+		const reach_search_obj curr = m_reach_queue[queue_ind];
+		for (int dir = 0; dir < 6; ++dir) {
+			// Never go back towards the camera, and only leave through faces connected to the one entered from
+			if (curr.used_dirs & (1u << (dir ^ 1))) continue;
+			if (curr.entered_face != -1 && !(curr.face_connections & (1u << world_chunk::face_pair_bit(curr.entered_face, dir)))) continue;
+
+			const world_pos next_offset = curr.offset + chunk_vals::dirs_xyz[dir];
+			const int32_t grid_index = reachable_index(&next_offset);
+			if (grid_index == -1 || m_reachable[static_cast<size_t>(grid_index)] == m_reach_stamp) continue;
+
+			// Look up the full chunk the first time its column is entered in this search
+			reach_column_obj &column = m_reach_columns[static_cast<size_t>(grid_index / chunk_vals::y_count)];
+			if (column.stamp != m_reach_stamp) {
+				const world_xzpos next_xz = { next_offset.x, next_offset.z };
+				column = { find_full_chunk_at(&next_xz), m_reach_stamp };
+			}
+			const world_full_chunk *const next_full_chunk = column.full_chunk;
+			if (!next_full_chunk) continue;
+			m_reachable[static_cast<size_t>(grid_index)] = m_reach_stamp;
+
+			// Connections of chunks being meshed are not known yet, so assume they are all connected
+			const bool is_meshing = next_full_chunk->full_state & world_full_chunk::state_en::generation_mark;
+			m_reach_queue.emplace_back(reach_search_obj{
+				next_offset,
+				is_meshing ? world_chunk::all_face_connections : next_full_chunk->subchunks[next_offset.y].face_connections,
+				static_cast<int8_t>(dir ^ 1), // Entering through the opposite face
+				static_cast<uint8_t>(curr.used_dirs | (1u << dir))
+			});
+		}
+	}
+
+	m_is_reach_culling = true;
+}
+
+void world_obj::hide_occluded_chunk(sort_slice_obj *slice, uint32_t chunk_ind) noexcept
+{
+	// Rotating does not change which rays are blocked, so this is never tested again when patching
+	set_chunk_visibility(slice, chunk_ind, false, math::lims<float>::max());
+	++slice->occluded_count;
+}
+
+void world_obj::set_chunk_visibility(sort_slice_obj *slice, uint32_t chunk_ind, bool is_visible, float rotation_margin) noexcept
+{
+	active_chunk_obj &it = active_chunks[chunk_ind];
+	it.is_visible = is_visible;
+	it.rotation_margin = rotation_margin;
+	if (rotation_margin <= max_patch_rotation) slice->boundary_chunks.emplace_back(chunk_ind);
+
+	const uint32_t chunk_squares = set_chunk_commands(it);
+	if (!is_visible) return;
+	slice->squares_count += chunk_squares;
+	++slice->chunks_count;
+}
+
+uint32_t world_obj::set_chunk_commands(const active_chunk_obj &it) noexcept
+{
+	const world_pos curr_offset = { it.xz_offset->x, it.y_offset, it.xz_offset->y };
+	uint32_t chunk_squares = 0;
+
+	for (int face_ind = 0; face_ind < 6; ++face_ind) {
+		const world_chunk::face_counts_obj *const face_counts = it.chunk->face_counters + face_ind;
+		
+		// Translucent faces are always drawn if the chunk is visible
+		if (face_counts->translucent_count) {
+			m_command_slots[it.translucent_slots[face_ind]].inst_count = it.is_visible ? face_counts->translucent_count : 0u;
+			chunk_squares += face_counts->translucent_count;
+		}
+		if (!face_counts->opaque_count) continue; // No slot if there are no normal faces
+
+		// Check if it would even be possible to see this (opaque) face of the chunk
+		// e.g. you can't see (relatively) forward faces in a chunk in front of you
+		bool is_face_shown = true;
+		switch (face_ind) {
+		case wdir_right:
+			if (m_sort_offset.x < curr_offset.x) is_face_shown = false;
+			break;
+		case wdir_left:
+			if (m_sort_offset.x > curr_offset.x) is_face_shown = false;
+			break;
+		case wdir_up:
+			if (m_sort_offset.y < curr_offset.y) is_face_shown = false;
+			break;
+		case wdir_down:
+			if (m_sort_offset.y > curr_offset.y) is_face_shown = false;
+			break;
+		case wdir_front:
+			if (m_sort_offset.z < curr_offset.z) is_face_shown = false;
+			break;
+		case wdir_back:
+			if (m_sort_offset.z > curr_offset.z) is_face_shown = false;
+			break;
+		default:
+			break;
+		}
+
+		indirect_cmd &opaque_cmd = m_command_slots[it.opaque_slots[face_ind]];
+		if (!is_face_shown) { opaque_cmd.inst_count = 0u; continue; }
+		opaque_cmd.inst_count = it.is_visible ? face_counts->opaque_count : 0u;
+		chunk_squares += face_counts->opaque_count;
+	}
+
+	return chunk_squares; // Number of squares drawn if the chunk is visible
+}
+
+int world_obj::lod_level_at(const world_xzpos *offset, const world_xzpos *center) noexcept
+{
+	const pos_t dist = chunk_vals::offsets_dist(offset, center);
+	int lod_level = 0;
+	for (pos_t level_dist = lod_start_dist; dist >= level_dist && lod_level < max_lod_level; level_dist *= 2) ++lod_level;
+	return lod_level;
+}
+
+uint32_t world_obj::get_lod_key(const world_xzpos *offset, const world_xzpos *center) noexcept
+{
+	// Skirts are needed towards any adjacent full chunk using a different level
+	const int lod_level = lod_level_at(offset, center);
+	uint32_t lod_key = static_cast<uint32_t>(lod_level);
+	for (int i = 0; i < 4; ++i) {
+		const world_xzpos nearby_offset = *offset + chunk_vals::dirs_xz[i];
+		if (lod_level_at(&nearby_offset, center) != lod_level) lod_key |= 1u << (world_full_chunk::lod_skirts_shift + i);
+	}
+	return lod_key;
+}
+
+world_full_chunk::mesh_key_obj world_obj::get_mesh_key(
+	const world_xzpos *offset,
+	const world_full_chunk *full_chunk,
+	uint32_t lod_key
+) const noexcept {
+	// A mesh depends on the blocks of its own full chunk and the bordering faces of the adjacent ones
+	world_full_chunk::mesh_key_obj key{ { full_chunk->version, 0u, 0u, 0u, 0u }, lod_key };
+	for (int i = 0; i < 4; ++i) {
+		const world_xzpos nearby_offset = *offset + chunk_vals::dirs_xz[i];
+		const world_full_chunk *const nearby_full_chunk = find_full_chunk_at(&nearby_offset);
+		if (nearby_full_chunk) key.versions[i + 1] = nearby_full_chunk->version;
+	}
+	return key;
+}
+
+void world_obj::cache_full_mesh(const world_xzpos *offset, world_full_chunk *full_chunk) noexcept
+{
+	// Only retain complete meshes that are not being changed by the generation thread
+	if (!full_chunk->has_been_meshed() || (full_chunk->full_state & world_full_chunk::state_en::generation_mark)) return;
+
+	// Take the resident quads of each subchunk, as they are no longer needed once the chunk leaves
+	cached_mesh_obj new_cached{ full_chunk->mesh_key, ++m_mesh_cache_uses, {}, {} };
+	for (int y = 0; y < chunk_vals::y_count; ++y) {
+		world_chunk *const chunk = full_chunk->subchunks + y;
+		::memcpy(new_cached.face_counters[y], chunk->face_counters, sizeof *new_cached.face_counters);
+		new_cached.quads[y] = chunk->resident_quads;
+		chunk->resident_quads = nullptr;
+	}
+
+	erase_cached_mesh(offset); // Replace any older mesh at the same offset
+
+	// Remove the least recently retained mesh if the limit has been reached
+	if (m_mesh_cache.size() >= mesh_cache_limit) {
+		const auto oldest = std::min_element(m_mesh_cache.begin(), m_mesh_cache.end(),
+			[](const decltype(m_mesh_cache)::value_type &a, const decltype(m_mesh_cache)::value_type &b) {
+				return a.second.last_use < b.second.last_use;
+			}
+		);
+		for (quad_data_t *quads : oldest->second.quads) delete[] quads;
+		m_mesh_cache.erase(oldest);
+	}
+
+	m_mesh_cache.insert(std::make_pair(*offset, new_cached));
+}
+
+bool world_obj::restore_cached_mesh(
+	const world_xzpos *offset,
+	world_full_chunk *full_chunk,
+	const world_full_chunk::mesh_key_obj *key,
+	world_chunk::face_counts_obj (*result_counters)[6]
+) const noexcept {
+	// Check if there is a retained mesh created from the same blocks
+	const auto found = m_mesh_cache.find(*offset);
+	if (found == m_mesh_cache.end() || !(found->second.key == *key)) return false;
+
+	// Give each subchunk face its own copy of the data like a newly created mesh
+	for (int y = 0; y < chunk_vals::y_count; ++y) {
+		world_chunk *const chunk = full_chunk->subchunks + y;
+		const quad_data_t *quads_src = found->second.quads[y];
+		::memcpy(result_counters[y], found->second.face_counters[y], sizeof *result_counters);
+		for (int i = 0; i < 6; ++i) {
+			const uint32_t dir_faces = result_counters[y][i].total_faces();
+			chunk->quads_ptr[i] = nullptr;
+			if (!dir_faces) continue;
+			chunk->quads_ptr[i] = new quad_data_t[dir_faces];
+			::memcpy(chunk->quads_ptr[i], quads_src, sizeof(quad_data_t) * dir_faces);
+			quads_src += dir_faces;
+		}
+	}
+
+	return true;
+}
+
+void world_obj::erase_cached_mesh(const world_xzpos *offset) noexcept
+{
+	const auto found = m_mesh_cache.find(*offset);
+	if (found == m_mesh_cache.end()) return;
+	for (quad_data_t *quads : found->second.quads) delete[] quads;
+	m_mesh_cache.erase(found);
 }
 
 int world_obj::fill_nearby_data(const world_pos *offset, nearby_data_obj *nearby_data, bool include_y) const noexcept
@@ -693,16 +1831,35 @@ world_obj::~world_obj()
 	m_gen_conditional.notify_all();
 	m_generation_thread.join();
 
+	// Stop sorting workers
+	{
+		std::lock_guard<std::mutex> sort_guard(m_sort_mutex);
+		m_is_sort_active = false;
+	}
+	m_sort_conditional.notify_all();
+	for (std::thread &sort_thread : m_sort_threads) sort_thread.join();
+
+	// Stop upload thread
+	{
+		std::lock_guard<std::mutex> upload_guard(m_upload_mutex);
+		m_is_upload_active = false;
+	}
+	m_upload_conditional.notify_all();
+	if (m_upload_thread.joinable()) m_upload_thread.join();
+	if (m_upload_batch.ready_fence) glDeleteSync(m_upload_batch.ready_fence);
+	if (m_upload_batch.written_fence) glDeleteSync(m_upload_batch.written_fence);
+
 	// Delete all created chunks
 	for (const auto &it : rendered_map) delete it.second;
 	for (const auto &it : m_generator.reserved_map) delete it.second;
+	for (const auto &it : m_mesh_cache) for (quad_data_t *quads : it.second.quads) delete[] quads;
+	for (const pending_release_obj &pending : m_pending_releases) glDeleteSync(pending.fence);
 	
 	// Delete created buffer objects
 	const GLuint delete_buffers[] = { 
 		m_world_ssbo, 
 		m_world_dib, 
 		m_world_inst_vbo, 
-		m_world_plane_vbo,
 		m_borders_ebo,
 		m_borders_vbo,
 	};
@@ -712,8 +1869,10 @@ world_obj::~world_obj()
 	const GLuint delete_vaos[] = { m_world_vao, m_borders_vao };
 	glDeleteVertexArrays(static_cast<GLsizei>(math::size(delete_vaos)), delete_vaos);
 
-	// Delete stored arrays
-	delete[] m_translucent_faces;
-	delete[] m_indirect_array;
-	delete[] m_shader_offset_array;
+	#if defined(VOXEL_DEBUG)
+	if (m_overdraw_queries[0]) glDeleteQueries(overdraw_queries, m_overdraw_queries);
+	#endif
+
+	// Delete stored arrays and fences
+	for (GLsync fence : m_stream_fences) if (fence) glDeleteSync(fence);
 }
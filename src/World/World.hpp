@@ -4,6 +4,7 @@
 
 #include "Player/PlayerDef.hpp"
 #include "Rendering/TextRenderer.hpp"
+#include "Rendering/Occlusion.hpp"
 
 class world_obj
 {
@@ -12,7 +13,8 @@ public:
 	noise_obj_list world_noise_objs;
 	world_acc_player *world_plr;
 	
-	size_t existing_quads_count = 0, rendered_squares_count, rendered_chunks_count;
+	size_t existing_quads_count = 0, rendered_squares_count, rendered_chunks_count, occluded_chunks_count = 0;
+	double overdraw_ratio = 0.0; // Samples passed by the world draw for each window pixel (debug builds only)
 
 	world_obj(world_acc_player *player) noexcept;
 	void draw_entire_world() noexcept;
@@ -28,7 +30,12 @@ public:
 	pos_t highest_solid_y_at(world_xzpos *xz_position) const noexcept;
 
 	void update_render_distance(int32_t new_rnd_dist) noexcept;
-	bool xz_in_rnd_dist(const world_xzpos *chunk_offset) const noexcept;
+	void update_gen_center() noexcept;
+	void retarget_generation() noexcept;
+	bool xz_in_rnd_dist(const world_xzpos *chunk_offset, int32_t extra_dist = 0) const noexcept;
+
+	void player_offset_changed() noexcept;
+	void set_unload_band(int32_t new_band, double new_dwell_time) noexcept;
 
 	uintmax_t fill_blocks(world_pos from, world_pos to, block_id new_block_id) noexcept;
 
@@ -36,6 +43,10 @@ public:
 	inline void signal_generation_thread() noexcept { m_do_gen_update = true; }
 
 	void sort_world_render() noexcept;
+	inline void update_pending_sort() noexcept { if (m_is_sort_pending) sort_world_render(); }
+	void update_render_base() noexcept;
+	const world_pos &get_render_base() const noexcept { return m_region_render_base; }
+	const world_xzpos &get_gen_center() const noexcept { return m_gen_center; }
 
 	struct nearby_data_obj {
 		world_chunk *chunk;
@@ -53,32 +64,185 @@ public:
 	int fill_nearby_full_data(const world_xzpos *offset, nearby_full_data_obj *nearby_full_data) const noexcept;
 
 	GLsizei get_ind_calls() const noexcept { return static_cast<size_t>(m_indirect_calls); }
+	size_t get_command_slots_count() const noexcept { return m_command_slots.size(); }
+	void set_column_layout(bool is_column_layout) noexcept;
+	bool is_column_layout() const noexcept { return m_is_column_layout; }
 	int32_t get_rnd_dist() const noexcept { return m_render_distance; }
+	int32_t get_unload_band() const noexcept { return m_unload_band; }
+	double get_center_dwell_time() const noexcept { return m_center_dwell_time; }
 	size_t get_chunks_count(bool include_height = true) const noexcept;
 
 	~world_obj();
 private:
 	quad_data_t *update_chunk_immediate(
-		const world_full_chunk *const full_chunk,
+		world_full_chunk *const full_chunk,
 		world_chunk *const updating_chunk,
 		const world_xzpos *const xz_offset,
 		pos_t y_offset,
 		quad_data_t *mesh_data_array
 	);
 
-	struct active_chunk_obj { world_chunk *chunk; const world_xzpos *xz_offset; pos_t y_offset; };
+	struct active_chunk_obj {
+		world_chunk *chunk;
+		const world_xzpos *xz_offset;
+		pos_t y_offset;
+		uint32_t lod_level;
+		uint32_t opaque_slots[6], translucent_slots[6]; // Command slot of each face direction (only valid if it has faces)
+		float rotation_margin; // Camera rotation before the visibility could change
+		bool is_visible;
+	};
 	std::vector<active_chunk_obj> active_chunks;
 
 	void update_inst_buffer_data() noexcept;
-	void update_world_arrays() noexcept;
+	void update_world_arrays(size_t new_capacity) noexcept;
+	void reserve_stream_capacity(size_t commands_count) noexcept;
+
+	// Each chunk with faces owns a range of the instance buffer so only changed meshes need to be uploaded
+	static constexpr uint32_t initial_inst_capacity = 1u << 20u;
+	static constexpr GLbitfield inst_buffer_flags = GL_DYNAMIC_STORAGE_BIT;
+	buffer_allocator_obj m_inst_allocator;
+
+	// Released ranges can still be in use by frames the GPU has not finished yet, so they are
+	// only given back to the allocator once a fence placed after the next draw has been reached
+	struct pending_release_obj { GLsync fence; std::vector<buffer_allocator_obj::range_obj> ranges; };
+	// Releases are only fenced once the region being drawn was written from command slots assigned after them,
+	// as the previous region keeps being drawn whilst a full sort is running
+	std::vector<buffer_allocator_obj::range_obj> m_unfenced_releases;
+	std::vector<pending_release_obj> m_pending_releases;
+	uint32_t m_unfenced_slots_serial = 0u;
+
+	// In the column layout every full chunk owns one range instead, containing the opaque faces of each subchunk in order
+	// followed by their translucent faces for each face direction. Commands of visible subchunks next to each other in
+	// a column can then be merged into one, as the Y offset of the subchunk is also stored in the quad data.
+	bool m_is_column_layout = true;
+
+	void store_resident_quads(world_chunk *chunk) noexcept;
+	void upload_chunk_mesh(world_chunk *chunk) noexcept;
+	void upload_column_mesh(world_full_chunk *full_chunk) noexcept;
+	void allocate_inst_range(uint32_t count, buffer_allocator_obj::range_obj *range) noexcept;
+	void grow_inst_buffer(uint32_t min_capacity) noexcept;
+	void release_inst_range(buffer_allocator_obj::range_obj *range) noexcept;
+	void process_pending_releases() noexcept;
+
+	// New meshes are written into the instance buffer by an upload thread using the context of a hidden window
+	// (sharing objects with the game window). The main thread only allocates their ranges and, once the fence
+	// placed after the writes is reached, swaps in the new buffer indices and commands. Until then the chunks
+	// keep their previous ranges, face counts and commands, so nothing can change them whilst a batch is pending.
+	enum class upload_state_en : uint8_t { idle, submitted, written };
+	struct upload_batch_obj {
+		// Resident quads are written straight from the chunks, as they cannot change whilst the batch is pending
+		struct write_obj { GLintptr offset; const quad_data_t *quads; uint32_t count; };
+		struct column_write_obj { // Resident quads of each subchunk, interleaved into the column layout by the writing thread
+			GLintptr offset;
+			uint32_t count;
+			const quad_data_t *sources[chunk_vals::y_count];
+			world_chunk::face_counts_obj counters[chunk_vals::y_count][6];
+		};
+		struct inds_obj { world_chunk *chunk; uint32_t data_inds[6], translucent_inds[6]; };
+		std::vector<write_obj> writes;
+		std::vector<column_write_obj> column_writes;
+		std::vector<quad_data_t> column_quads; // Only used by the thread writing the batch
+		std::vector<inds_obj> inds; // Buffer indices given to chunks once the batch is written
+		std::vector<buffer_allocator_obj::range_obj> releases; // Previous ranges, released once the batch is written
+		GLuint buffer = 0u;
+		GLsync ready_fence = nullptr, written_fence = nullptr;
+		bool has_writes() const noexcept { return !writes.empty() || !column_writes.empty(); }
+	} m_upload_batch;
+	std::atomic<upload_state_en> m_upload_state{ upload_state_en::idle };
+	std::mutex m_upload_mutex;
+	std::condition_variable m_upload_conditional;
+	std::thread m_upload_thread;
+	bool m_is_upload_active = true;
+
+	bool is_upload_pending() const noexcept { return m_upload_state != upload_state_en::idle; }
+	void stage_range_release(buffer_allocator_obj::range_obj *range) noexcept;
+	upload_batch_obj::inds_obj *stage_chunk_inds(world_chunk *chunk) noexcept;
+	void stage_quads_write(uint32_t inst_start, const quad_data_t *quads, uint32_t count) noexcept;
+	void submit_upload_batch() noexcept;
+	void write_upload_batch() noexcept;
+	bool apply_upload_batch(bool do_wait) noexcept;
+	void apply_staged_changes() noexcept;
+	void rebuild_active_chunks() noexcept;
+	void upload_loop() noexcept;
+
+	// Mesh data of full chunks that left render distance, reused if they return with the same mesh key
+	struct cached_mesh_obj {
+		world_full_chunk::mesh_key_obj key;
+		uintmax_t last_use;
+		world_chunk::face_counts_obj face_counters[chunk_vals::y_count][6];
+		quad_data_t *quads[chunk_vals::y_count]; // Resident quads taken from each subchunk
+	};
+	std::unordered_map<world_xzpos, cached_mesh_obj, vec_hash> m_mesh_cache;
+	uintmax_t m_mesh_cache_uses = 0;
+	static constexpr size_t mesh_cache_limit = 256;
+
+	world_full_chunk::mesh_key_obj get_mesh_key(
+		const world_xzpos *offset,
+		const world_full_chunk *full_chunk,
+		uint32_t lod_key
+	) const noexcept;
+
+	// Full chunks further from the generation center are meshed with less detail, each level starting at double
+	// the distance of the previous one. Chunks are meshed again whenever their detail (or skirts) would change.
+	static constexpr pos_t lod_start_dist = 8;
+	static constexpr int max_lod_level = 3;
+	static int lod_level_at(const world_xzpos *offset, const world_xzpos *center) noexcept;
+	static uint32_t get_lod_key(const world_xzpos *offset, const world_xzpos *center) noexcept;
+	void cache_full_mesh(const world_xzpos *offset, world_full_chunk *full_chunk) noexcept;
+	bool restore_cached_mesh(
+		const world_xzpos *offset,
+		world_full_chunk *full_chunk,
+		const world_full_chunk::mesh_key_obj *key,
+		world_chunk::face_counts_obj (*result_counters)[6]
+	) const noexcept;
+	void erase_cached_mesh(const world_xzpos *offset) noexcept;
 
 	GLuint m_borders_vao, m_borders_vbo, m_borders_ebo;
-	GLuint m_world_vao, m_world_inst_vbo, m_world_plane_vbo;
-	GLuint m_world_ssbo, m_world_dib;
-	GLsizei m_indirect_calls;
+	GLuint m_world_vao, m_world_inst_vbo;
+	GLuint m_world_ssbo = 0u, m_world_dib = 0u;
+	GLsizei m_indirect_calls = 0;
+
+	// Indirect commands and SSBO offsets are written straight into persistently mapped buffers, each split
+	// into regions so that new commands can be written while the GPU may still be reading older ones
+	static constexpr int stream_regions = 3;
+	static constexpr GLbitfield stream_map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	uint8_t *m_indirect_mapped = nullptr, *m_shader_offset_mapped = nullptr;
+	GLsizeiptr m_indirect_region_bytes = 0, m_shader_offset_region_bytes = 0;
+	GLsync m_stream_fences[stream_regions]{};
+
+	// Regions are sized from the number of command slots rather than the render distance, growing geometrically
+	// and only shrinking once far fewer slots are used so that small changes never recreate the buffers
+	static constexpr size_t min_stream_capacity = 1024u, stream_shrink_factor = 4u;
+	size_t m_stream_capacity = 0; // Number of commands that fit in each region
+	int m_stream_region = 0;
+	bool m_is_region_drawn = false, m_is_region_written = false; // New buffers have nothing to draw until a region is written
+
+	void wait_stream_region(int region) noexcept;
 
 	int32_t m_render_distance = 4;
 
+	// Chunks are loaded inside the render distance but only unloaded once they are further than
+	// the render distance + unload band from the generation center, which only follows the player
+	// once they have stayed in another chunk for the dwell time (or moved past the unload band)
+	world_xzpos m_gen_center;
+	vector2f m_gen_view_dir; // XZ camera direction when the generation center was set
+
+	// Incremented whenever the generation target area changes (e.g. teleporting) so that the
+	// generation thread can drop work outside of the new area instead of finishing the cycle
+	std::atomic<uint32_t> m_gen_epoch{ 0u };
+	struct gen_target_obj { world_xzpos center; int32_t rnd_dist; } m_gen_target;
+	std::mutex m_gen_target_mutex;
+	bool is_outside_gen_target(const world_xzpos *offset, int32_t extra_dist, uint32_t cycle_epoch) noexcept;
+
+	// Generate and mesh only the player's full chunk and its 4 neighbours first when there is no nearby
+	// terrain (entering the world or teleporting far away), then follow with the full render distance
+	static constexpr int32_t spawn_rnd_dist = 1;
+	std::atomic<bool> m_do_spawn_fast_path{ true };
+	bool m_was_spawn_fast_path = false, m_has_first_terrain = false;
+	double m_creation_time;
+	std::atomic<int32_t> m_unload_band{ 1 }; // Also read by the generation thread, which copies it once per cycle
+	double m_center_dwell_time = 0.5, m_offset_change_time = 0.0;
+
 	enum gen_state_en : uint8_t {
 		both_finish,
 		gen_finished,
@@ -87,7 +251,7 @@ private:
 		await_confirm,
 		active_immediate
 	} m_gen_thread_state = gen_state_en::active;
-	bool m_do_buffers_update = false, m_do_gen_update = false, m_do_arrays_update = false;
+	bool m_do_buffers_update = false, m_do_gen_update = false;
 
 	bool gen_thread_conditional_wait(gen_state_en new_state);
 
@@ -95,24 +259,130 @@ private:
 	std::thread m_generation_thread;
 
 	struct ssbo_offset_data {
-		double wrld_x, wrld_z;
-		float wrld_y;
-		uint32_t face_ind;
-	} *m_shader_offset_array = nullptr;
+		int32_t rel_x, rel_y, rel_z; // Full chunk corner in blocks relative to the render base chunk
+		uint32_t face_ind; // Level of detail is stored above the face index
+	} *m_shader_offset_array = nullptr; // Current region of the mapped SSBO
 	struct indirect_cmd {
 		GLuint count;
 		GLuint inst_count;
 		GLuint first;
 		GLuint base_inst;
-	} *m_indirect_array = nullptr;
-	struct translucent_render_data {
-		ssbo_offset_data ssbo_data;
-		const world_chunk *chunk;
-	} *m_translucent_faces = nullptr;
+	} *m_indirect_array = nullptr; // Current region of the mapped indirect buffer
+	// Every face direction of an active chunk has a fixed command slot (opaque slots first, then translucent),
+	// so visibility changes only need to set the instance counts of the affected slots before the commands are
+	// copied into the next mapped region. Slots of hidden chunk faces are kept with an instance count of 0.
+	// Offsets are of the full chunk corner, as the subchunk is given by the quad data.
+	std::vector<indirect_cmd> m_command_slots;
+	std::vector<ssbo_offset_data> m_offset_slots;
+	static constexpr uint32_t ssbo_lod_shift = 3u;
+
+	// Consecutive active chunks of the same full chunk, bounded by the lowest and highest of them
+	// so that entire columns can be culled (or accepted) before testing individual subchunks
+	struct active_column_obj { uint32_t first_chunk, end_chunk; pos_t min_y, max_y; };
+	std::vector<active_column_obj> m_active_columns;
+
+	// A full sort splits the active columns into partitions for each worker, which also collect the chunks
+	// close enough to a frustum plane that they need to be tested again when the camera rotates
+	struct sort_slice_obj {
+		std::vector<uint32_t> boundary_chunks, partial_chunks;
+		size_t squares_count, chunks_count, occluded_count;
+	};
+	std::vector<sort_slice_obj> m_sort_slices;
+	std::vector<uint32_t> m_boundary_chunks;
+	static constexpr size_t sort_columns_per_thread = 128; // Minimum columns for each extra sorting worker
+
+	// Full sorts run on persistent workers. The main thread only starts them and collects their slices on a later
+	// frame (or later in the same frame), drawing the previous region meanwhile. Each sort has two phases: the workers
+	// first draw their part of the occluders (one searching for reachable chunks instead if there are several), then
+	// the last one to finish merges the depth buffers and each worker tests the active columns of one partition.
+	// Whilst a sort is running, nothing the workers read (active chunks, command slots, face counts, the render map)
+	// is changed.
+	std::vector<std::thread> m_sort_threads;
+	std::mutex m_sort_mutex;
+	std::condition_variable m_sort_conditional;
+	uint32_t m_sort_serial = 0u; // Changed to start the workers
+	size_t m_sort_partitions = 0u, m_sort_finished = 0u, m_sort_prepared = 0u;
+	int m_occlusion_parts = 1;
+	bool m_is_sort_active = true, m_is_sort_pending = false, m_is_sort_prepared = false;
+	world_pos m_sort_offset{}; // Camera chunk of the sort frustum
+	int32_t m_sort_reach_radius = 0; // Reachable chunks are searched for up to this distance from the camera chunk
+	uint32_t m_slots_serial = 0u, m_region_slots_serial = 0u; // Changed whenever command slots are assigned
+
+	// Rotating further than this from the frustum used in the last full sort (or moving at all) causes a full sort
+	static constexpr float max_patch_rotation = 0.25f;
+	// Chunks this close to being visible are drawn as well, so turning whilst the next full sort is running
+	// does not show gaps at the edges of the screen (they are hidden again by patching once the sort is used)
+	static constexpr float pending_sort_rotation = 0.05f;
+	camera_frustum m_sort_frustum;
+	bool m_do_full_sort = true;
+
+	// Chunk offsets given to the shader are relative to this chunk, so only floats are needed on the GPU.
+	// It only changes once the camera is far enough away from it, which needs all command slots to be refilled.
+	static constexpr pos_t render_base_dist = 4;
+	world_pos m_render_base{}, m_region_render_base{}; // The shader uses the base of the region being drawn
+
+	// Command slots are assigned in order of (squared) distance from the camera chunk using a counting sort, so
+	// opaque faces are drawn front to back to reduce overdraw and translucent faces are drawn back to front
+	std::vector<uint32_t> m_slot_order, m_distance_counts;
+	world_pos m_slot_order_center{};
+
+	#if defined(VOXEL_DEBUG)
+	// Samples passed by the world draw, only read back once the result is available so it never stalls
+	static constexpr int overdraw_queries = 3;
+	GLuint m_overdraw_queries[overdraw_queries]{};
+	bool m_is_query_pending[overdraw_queries]{};
+	int m_overdraw_query = 0;
+
+	void begin_overdraw_query() noexcept;
+	void end_overdraw_query() noexcept;
+	#endif
+
+	// Runs of fully opaque subchunks in each column, drawn into a coarse depth buffer before a full sort
+	// so that chunks behind them can be skipped. Hidden chunks stay hidden when the camera only rotates.
+	occlusion_buffer_obj m_occlusion;
+	std::vector<occlusion_buffer_obj::box_obj> m_occluders;
+
+	// Subchunks that can be seen from the camera chunk through connected non-opaque blocks, found with a
+	// breadth-first search that never turns back towards the camera (cave culling). Stored in a grid of
+	// subchunks around the camera chunk, which like occlusion only depends on the camera position.
+	// Grid entries hold the stamp of the search that reached them so the grid never needs to be cleared,
+	// and the full chunk of each column is only looked up once per search.
+	struct reach_search_obj { world_pos offset; uint16_t face_connections; int8_t entered_face; uint8_t used_dirs; };
+	struct reach_column_obj { const world_full_chunk *full_chunk; uint32_t stamp; };
+	std::vector<reach_search_obj> m_reach_queue;
+	std::vector<uint32_t> m_reachable;
+	std::vector<reach_column_obj> m_reach_columns;
+	uint32_t m_reach_stamp = 0u;
+	world_pos m_reachable_origin;
+	int32_t m_reachable_width = 0;
+	bool m_is_reach_culling = false;
+
+	void update_reachable_chunks() noexcept;
+	int32_t reachable_index(const world_pos *offset) const noexcept;
+
+	void assign_command_slots() noexcept;
+	void write_stream_region() noexcept;
+	GLsizei write_column_commands() noexcept;
+	void start_full_sort() noexcept;
+	bool finish_full_sort(bool do_wait) noexcept;
+	void discard_full_sort() noexcept;
+	void sort_worker_loop(size_t worker_ind) noexcept;
+	void prepare_sort_part(size_t worker_ind) noexcept;
+	bool patch_sort_render() noexcept;
+	void sort_columns_slice(sort_slice_obj *slice, size_t index, size_t end) noexcept;
+	void set_chunk_visibility(sort_slice_obj *slice, uint32_t chunk_ind, bool is_visible, float rotation_margin) noexcept;
+	bool is_chunk_occluded(uint32_t chunk_ind) const noexcept;
+	void hide_occluded_chunk(sort_slice_obj *slice, uint32_t chunk_ind) noexcept;
+	uint32_t set_chunk_commands(const active_chunk_obj &active_chunk) noexcept;
 
 	struct world_chunk_generator {
 	public:
-		void generate_surrounding(const world_xzpos *const curr_xz_offset, int32_t curr_rnd_dist) noexcept;
+		void generate_surrounding(
+			const world_xzpos *const curr_xz_offset,
+			int32_t curr_rnd_dist,
+			const vector2f *const view_dir,
+			uint32_t gen_epoch
+		) noexcept;
 		bool can_del_full_chunk(
 			const world_full_chunk *const full_chunk,
 			const world_xzpos *const full_chunk_xz_offset,
@@ -127,18 +397,24 @@ private:
 	private:
 		std::mutex reserved_access_mutex;
 
+		// Offsets around the player in generation order, recreated when the generation distance changes
+		struct gen_order_obj { world_xzpos offset; float priority; };
+		std::vector<gen_order_obj> gen_order;
+		int32_t gen_order_dist = -1;
+		static constexpr float view_priority_bias = 0.5f;
+
 		struct full_chunk_result { world_full_chunk *const full_chunk; noise_object::block_noise *const noise_table; };
 		full_chunk_result create_full_chunk(const world_xzpos *const xz_offset);
-		world_chunk *create_or_get_chunk(const world_pos *const offset);
-		world_chunk *get_chunk(const world_pos *const offset);
+		world_full_chunk *create_or_get_full_chunk(const world_xzpos *const xz_offset);
+		world_full_chunk *get_full_chunk(const world_xzpos *const xz_offset);
 		
-		block_id &create_block_ref(const world_pos *const position);
+		block_id &create_block_ref(const world_pos *const position, bool is_changing);
 
 		inline block_id local_get(const world_pos *const position) {
-			return create_block_ref(position);
+			return create_block_ref(position, false);
 		}
 		inline void local_set(const world_pos *const position, block_id new_block_id) {
-			create_block_ref(position) = new_block_id;
+			create_block_ref(position, true) = new_block_id;
 		}
 
 		void natural_set(const world_pos *const position, const block_properties::block_attributes *block_properties);